@@ -11,6 +11,7 @@ import matplotlib.pyplot as plt
 import numpy as np
 import time
 import re
+import shutil
 
 class TopologyAnalyzer:
     def __init__(self, ns3_path="~/ns-allinone-3.45/ns-3.45"):
@@ -94,6 +95,11 @@ class TopologyAnalyzer:
             print(f"    [Warning] {filename} not found")
             return None
         
+        # Outil natif (trace_analyzer.cpp) : mêmes résultats, bien plus rapide
+        native = self.analyze_trace_file_native(filepath)
+        if native is not None:
+            return native
+        
         # Filtrer UNIQUEMENT les paquets UDP Echo (port 9)
         udp_packets_tx = {}  # uid -> (time, size)
         udp_packets_rx = {}  # uid -> (time, size)
@@ -183,6 +189,32 @@ class TopologyAnalyzer:
             print(f"    [Error] Trace analysis failed: {e}")
             return None
     
+    def analyze_trace_file_native(self, filepath):
+        """Analyse via trace_analyzer (compilé depuis trace_analyzer.cpp), None s'il est absent"""
+        
+        tool = shutil.which('trace_analyzer')
+        local = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'trace_analyzer')
+        if tool is None and os.access(local, os.X_OK):
+            tool = local
+        if tool is None:
+            return None
+        
+        try:
+            result = subprocess.run([tool, filepath], capture_output=True, text=True)
+        except OSError:
+            return None
+        if result.returncode != 0:
+            return None
+        
+        metrics = {}
+        for line in result.stdout.splitlines():
+            key, _, value = line.partition('=')
+            if key in ('lost', 'tx_packets', 'rx_packets'):
+                metrics[key] = int(value)
+            else:
+                metrics[key] = float(value)
+        return metrics
+    
     def vary_wifi_nodes(self, wifi_range=range(1, 10), nCsma_fixed=3):
         """Varie le nombre de nœuds WiFi"""
         
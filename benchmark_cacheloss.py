@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Mesure du gain de --cacheLoss sur question5-2 (flux à 10 µs).
+
+Lance question5-2 alternativement avec --cacheLoss=0 et --cacheLoss=1,
+relève la ligne "Events: N in W s (R events/s ...)" affichée après
+Simulator::Run() et compare les médianes. Le temps mesuré est celui de la
+simulation seule, sans compilation ni démarrage de ns3.
+"""
+import re
+import statistics
+import subprocess
+import sys
+
+NS3_PATH = "/home/ubuntu/ns-allinone-3.45/ns-3.45"
+SCRIPT = "scratch/question5-2"
+REPETITIONS = 5
+EVENTS = re.compile(r'Events:\s*(\d+) in ([\d.e+-]+) s \(([\d.e+-]+) events/s')
+
+
+def run(cache_loss, duration):
+    cmd = f"./ns3 run --no-build '{SCRIPT} --cacheLoss={cache_loss} --duration={duration}'"
+    result = subprocess.run(cmd, cwd=NS3_PATH, shell=True, capture_output=True, text=True)
+    match = EVENTS.search(result.stdout)
+    if result.returncode != 0 or not match:
+        print(result.stdout + result.stderr)
+        sys.exit(f"ERREUR : question5-2 --cacheLoss={cache_loss} a échoué")
+    return int(match.group(1)), float(match.group(2)), float(match.group(3))
+
+
+def main():
+    duration = float(sys.argv[1]) if len(sys.argv) > 1 else 10.0
+    subprocess.run("./ns3 build", cwd=NS3_PATH, shell=True, check=True)
+
+    runs = {0: [], 1: []}
+    for _ in range(REPETITIONS):
+        # Alterner limite l'effet d'une dérive de la machine sur un seul mode
+        for cache_loss in (0, 1):
+            runs[cache_loss].append(run(cache_loss, duration))
+
+    print("\ncacheLoss  événements  temps médian (s)  événements/s médian")
+    rate = {}
+    for cache_loss, samples in runs.items():
+        wall = statistics.median(s[1] for s in samples)
+        rate[cache_loss] = statistics.median(s[2] for s in samples)
+        print(f"{cache_loss:9d}  {samples[0][0]:10d}  {wall:16.3f}  {rate[cache_loss]:19.0f}")
+    if len({s[0] for samples in runs.values() for s in samples}) != 1:
+        print("Attention : le nombre d'événements diffère entre les deux modes")
+    print(f"Gain : {100.0 * (rate[1] / rate[0] - 1):+.1f} % d'événements/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,173 @@
+/*
+ * Memoized propagation loss for scenarios whose nodes rarely move.
+ *
+ * CachedPropagationLossModel wraps a deterministic loss chain (log-distance,
+ * range, ...) and remembers the received power per (tx, rx) mobility pair.
+ * An entry is reused until either node fires CourseChange, so static
+ * topologies evaluate the chain once per pair instead of once per packet.
+ * Pairs live in a dense table up to DENSE_LIMIT nodes and in a hash map
+ * above that.
+ */
+
+#ifndef CACHED_PROPAGATION_LOSS_H
+#define CACHED_PROPAGATION_LOSS_H
+
+#include "ns3/callback.h"
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class CachedPropagationLossModel : public PropagationLossModel
+{
+  public:
+    static constexpr uint32_t DENSE_LIMIT = 1024;
+
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::CachedPropagationLossModel")
+                                .SetParent<PropagationLossModel>()
+                                .SetGroupName("Propagation")
+                                .AddConstructor<CachedPropagationLossModel>();
+        return tid;
+    }
+
+    /// Loss chain to memoize; it must not draw random variables.
+    void SetInner(Ptr<PropagationLossModel> inner)
+    {
+        m_inner = inner;
+        m_index.clear();
+        m_epoch.clear();
+        m_dense.clear();
+        m_hashed.clear();
+        m_capacity = 0;
+    }
+
+    uint64_t GetHits() const
+    {
+        return m_hits;
+    }
+
+    uint64_t GetMisses() const
+    {
+        return m_misses;
+    }
+
+  private:
+    struct Entry
+    {
+        double txPowerDbm;
+        double rxPowerDbm;
+        uint32_t epochA; //!< epochs of both nodes when computed; 0 = empty
+        uint32_t epochB;
+    };
+
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override
+    {
+        const uint32_t i = Index(a);
+        const uint32_t j = Index(b);
+        Entry& e = Lookup(i, j);
+        if (e.epochA == m_epoch[i] && e.epochB == m_epoch[j] && e.txPowerDbm == txPowerDbm)
+        {
+            m_hits++;
+            return e.rxPowerDbm;
+        }
+        m_misses++;
+        e.txPowerDbm = txPowerDbm;
+        e.rxPowerDbm = m_inner->CalcRxPower(txPowerDbm, a, b);
+        e.epochA = m_epoch[i];
+        e.epochB = m_epoch[j];
+        return e.rxPowerDbm;
+    }
+
+    int64_t DoAssignStreams(int64_t stream) override
+    {
+        return m_inner ? m_inner->AssignStreams(stream) : 0;
+    }
+
+    /// Dense index of a mobility model, watching its course changes.
+    uint32_t Index(const Ptr<MobilityModel>& model) const
+    {
+        auto it = m_index.find(PeekPointer(model));
+        if (it != m_index.end())
+        {
+            return it->second;
+        }
+        const uint32_t index = static_cast<uint32_t>(m_epoch.size());
+        m_index.emplace(PeekPointer(model), index);
+        m_epoch.push_back(1);
+        model->TraceConnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&CachedPropagationLossModel::Invalidate,
+                         const_cast<CachedPropagationLossModel*>(this)));
+        return index;
+    }
+
+    void Invalidate(Ptr<const MobilityModel> model)
+    {
+        auto it = m_index.find(PeekPointer(model));
+        if (it != m_index.end())
+        {
+            m_epoch[it->second]++;
+        }
+    }
+
+    Entry& Lookup(uint32_t i, uint32_t j) const
+    {
+        const uint32_t n = static_cast<uint32_t>(m_epoch.size());
+        if (n > DENSE_LIMIT)
+        {
+            return m_hashed[(static_cast<uint64_t>(i) << 32) | j];
+        }
+        if (n > m_capacity)
+        {
+            // Grow geometrically and carry the computed entries over.
+            uint32_t capacity = std::max<uint32_t>(16, m_capacity);
+            while (capacity < n)
+            {
+                capacity *= 2;
+            }
+            capacity = std::min(capacity, DENSE_LIMIT);
+            std::vector<Entry> dense(static_cast<size_t>(capacity) * capacity, Entry{0, 0, 0, 0});
+            for (uint32_t r = 0; r < m_capacity; r++)
+            {
+                std::copy_n(&m_dense[static_cast<size_t>(r) * m_capacity],
+                            m_capacity,
+                            &dense[static_cast<size_t>(r) * capacity]);
+            }
+            m_dense.swap(dense);
+            m_capacity = capacity;
+        }
+        return m_dense[static_cast<size_t>(i) * m_capacity + j];
+    }
+
+    Ptr<PropagationLossModel> m_inner;
+    mutable std::unordered_map<const MobilityModel*, uint32_t> m_index;
+    mutable std::vector<uint32_t> m_epoch;
+    mutable std::vector<Entry> m_dense;
+    mutable std::unordered_map<uint64_t, Entry> m_hashed;
+    mutable uint32_t m_capacity = 0;
+    mutable uint64_t m_hits = 0;
+    mutable uint64_t m_misses = 0;
+};
+
+/// Cache in front of chain, ready for YansWifiChannel::SetPropagationLossModel.
+inline Ptr<CachedPropagationLossModel>
+CreateCachedLoss(Ptr<PropagationLossModel> chain)
+{
+    Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel>();
+    cached->SetInner(chain);
+    return cached;
+}
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_LOSS_H */
@@ -0,0 +1,221 @@
+/*
+ * End-of-run aggregation of FlowMonitor statistics.
+ *
+ * Counters are 64-bit and durations are kept as Time (integer
+ * nanoseconds) until the final division, so long, high-rate runs neither
+ * wrap nor lose the sub-second part of a flow's lifetime. Each flow is
+ * assigned to the load phase its first packet was sent in; throughput is
+ * given per flow, per phase and overall, together with Jain's fairness
+ * index over the per-flow throughputs. Everything can be written as JSON.
+ */
+
+#ifndef FLOW_METRICS_H
+#define FLOW_METRICS_H
+
+#include "ns3/flow-monitor.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+namespace ns3
+{
+
+class FlowMetrics
+{
+  public:
+    struct Totals
+    {
+        uint64_t flows = 0;
+        uint64_t txPackets = 0;
+        uint64_t rxPackets = 0;
+        uint64_t lostPackets = 0;
+        uint64_t txBytes = 0;
+        uint64_t rxBytes = 0;
+        Time delaySum;
+        Time first = Time::Max(); //!< first packet sent
+        Time last = Time::Min();  //!< last packet received
+        double fairness = 0;
+
+        /// Received kbit/s (1 kbit = 1000 bits) between first and last.
+        double ThroughputKbps() const
+        {
+            return last > first ? rxBytes * 8e6 / (last - first).GetNanoSeconds() : 0;
+        }
+
+        /// Received over sent packets, in percent.
+        double Pdr() const
+        {
+            return txPackets ? 100.0 * rxPackets / txPackets : 0;
+        }
+
+        Time MeanDelay() const
+        {
+            return rxPackets ? delaySum / rxPackets : Time(0);
+        }
+    };
+
+    struct Flow
+    {
+        FlowId id;
+        Ipv4FlowClassifier::FiveTuple tuple;
+        uint32_t phase; //!< 1-based, 0 before the first phase
+        Totals totals;  //!< of this flow alone
+    };
+
+    /// Load phase k (1-based) starts at starts[k - 1].
+    void SetPhases(const std::vector<Time>& starts)
+    {
+        m_starts = starts;
+    }
+
+    /// Aggregate the current statistics of monitor.
+    void Collect(Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier)
+    {
+        monitor->CheckForLostPackets();
+        m_flows.clear();
+        m_total = Totals();
+        m_phases.assign(m_starts.size() + 1, Totals());
+        for (const auto& [id, stats] : monitor->GetFlowStats())
+        {
+            Flow flow;
+            flow.id = id;
+            flow.tuple = classifier->FindFlow(id);
+            flow.phase =
+                std::upper_bound(m_starts.begin(), m_starts.end(), stats.timeFirstTxPacket) -
+                m_starts.begin();
+            Totals& t = flow.totals;
+            t.flows = 1;
+            t.txPackets = stats.txPackets;
+            t.rxPackets = stats.rxPackets;
+            t.lostPackets = stats.lostPackets;
+            t.txBytes = stats.txBytes;
+            t.rxBytes = stats.rxBytes;
+            t.delaySum = stats.delaySum;
+            t.first = stats.timeFirstTxPacket;
+            t.last = stats.rxPackets ? stats.timeLastRxPacket : stats.timeFirstTxPacket;
+            t.fairness = 1;
+            Add(m_total, t);
+            Add(m_phases[flow.phase], t);
+            m_flows.push_back(flow);
+        }
+        m_total.fairness = Fairness(0, false);
+        for (uint32_t k = 0; k < m_phases.size(); k++)
+        {
+            m_phases[k].fairness = Fairness(k, true);
+        }
+    }
+
+    const Totals& GetTotals() const
+    {
+        return m_total;
+    }
+
+    /// Totals of phase k (0 = flows started before the first phase).
+    const Totals& GetPhase(uint32_t k) const
+    {
+        return m_phases[k];
+    }
+
+    const std::vector<Flow>& GetFlows() const
+    {
+        return m_flows;
+    }
+
+    /// {"total": {...}, "phases": [...], "flows": [...]}; empty phases are skipped.
+    void WriteJson(std::ostream& os) const
+    {
+        std::ostringstream json;
+        json.precision(10);
+        json << "{\n  \"total\": ";
+        WriteTotals(json, m_total);
+        json << ",\n  \"phases\": [";
+        const char* separator = "\n";
+        for (uint32_t k = 0; k < m_phases.size(); k++)
+        {
+            if (m_phases[k].flows == 0)
+            {
+                continue;
+            }
+            json << separator << "    {\"phase\": " << k << ", \"start\": "
+                 << (k ? m_starts[k - 1].GetSeconds() : 0.0) << ", \"metrics\": ";
+            WriteTotals(json, m_phases[k]);
+            json << "}";
+            separator = ",\n";
+        }
+        json << "\n  ],\n  \"flows\": [";
+        separator = "\n";
+        for (const Flow& flow : m_flows)
+        {
+            json << separator << "    {\"id\": " << flow.id << ", \"phase\": " << flow.phase
+                 << ", \"source\": \"" << flow.tuple.sourceAddress << ":" << flow.tuple.sourcePort
+                 << "\", \"destination\": \"" << flow.tuple.destinationAddress << ":"
+                 << flow.tuple.destinationPort << "\", \"protocol\": "
+                 << uint32_t(flow.tuple.protocol) << ", \"metrics\": ";
+            WriteTotals(json, flow.totals);
+            json << "}";
+            separator = ",\n";
+        }
+        json << "\n  ]\n}\n";
+        os << json.str();
+    }
+
+  private:
+    static void Add(Totals& sum, const Totals& t)
+    {
+        sum.flows += t.flows;
+        sum.txPackets += t.txPackets;
+        sum.rxPackets += t.rxPackets;
+        sum.lostPackets += t.lostPackets;
+        sum.txBytes += t.txBytes;
+        sum.rxBytes += t.rxBytes;
+        sum.delaySum += t.delaySum;
+        sum.first = std::min(sum.first, t.first);
+        sum.last = std::max(sum.last, t.last);
+    }
+
+    /// Jain's index (sum x)^2 / (n sum x^2) over flow throughputs, of phase k if inPhase.
+    double Fairness(uint32_t k, bool inPhase) const
+    {
+        double sum = 0;
+        double squares = 0;
+        uint64_t n = 0;
+        for (const Flow& flow : m_flows)
+        {
+            if (inPhase && flow.phase != k)
+            {
+                continue;
+            }
+            const double x = flow.totals.ThroughputKbps();
+            sum += x;
+            squares += x * x;
+            n++;
+        }
+        return squares > 0 ? sum * sum / (n * squares) : 0;
+    }
+
+    static void WriteTotals(std::ostream& json, const Totals& t)
+    {
+        json << "{\"flows\": " << t.flows << ", \"tx_packets\": " << t.txPackets
+             << ", \"rx_packets\": " << t.rxPackets << ", \"lost_packets\": " << t.lostPackets
+             << ", \"tx_bytes\": " << t.txBytes << ", \"rx_bytes\": " << t.rxBytes
+             << ", \"first_tx\": " << (t.flows ? t.first.GetSeconds() : 0.0)
+             << ", \"last_rx\": " << (t.flows ? t.last.GetSeconds() : 0.0)
+             << ", \"throughput_kbps\": " << t.ThroughputKbps() << ", \"pdr\": " << t.Pdr()
+             << ", \"mean_delay_ms\": " << t.MeanDelay().GetSeconds() * 1e3
+             << ", \"fairness\": " << t.fairness << "}";
+    }
+
+    std::vector<Time> m_starts;
+    std::vector<Flow> m_flows;
+    std::vector<Totals> m_phases; //!< indexed by phase
+    Totals m_total;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_METRICS_H */
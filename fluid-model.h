@@ -0,0 +1,214 @@
+/*
+ * Flow-level model of the WiFi - P2P - CSMA echo scenario.
+ *
+ * STAs send UDP echo requests through the AP, across the point-to-point
+ * link, to a server on the CSMA segment, which sends every request back.
+ * The 802.11a cell is a shared server whose frame rate comes from
+ * Bianchi's DCF saturation analysis and is split max-min fairly between
+ * the stations that contend (the STAs and, for the replies, the AP); the
+ * P2P link is a 5 Mbps drop-tail queue in each direction. Rates are
+ * solved as a fixed point (the AP only has the replies to what got
+ * through), which takes microseconds instead of a packet-level run. The
+ * delay is an estimate: access time plus M/D/1 waiting at the P2P queue,
+ * or a full buffer once a queue is overloaded.
+ *
+ * The model has not been validated against packet-level runs yet, so its
+ * error bounds are unknown; fluid_calibration.py runs the comparison grid.
+ */
+
+#ifndef FLUID_MODEL_H
+#define FLUID_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct FluidInput
+{
+    uint32_t stations = 3;        //!< STAs, each sending the same rate
+    double offeredBps = 8192;     //!< all STAs together, UDP payload bits/s
+    uint32_t packetSize = 1024;   //!< UDP payload bytes
+    bool echo = true;             //!< the server sends every packet back
+    /**
+     * 802.11a data rate. The scenario uses AarfWifiManager, which starts at
+     * 6 Mbps, climbs one rate after 10 successes and falls back after 2
+     * failures. 54 Mbps assumes AARF has climbed (clean 10 m links, steady
+     * traffic). At low load it may never get there, and collisions at
+     * saturation push it down, so the packet run can have less capacity.
+     */
+    double dataRateMbps = 54;
+    double ackRateMbps = 24;      //!< control rate of the ACKs
+    double p2pBps = 5e6;
+    double p2pDelay = 2e-3;       //!< seconds
+    uint32_t p2pQueue = 100;      //!< packets (DropTail default)
+    uint32_t wifiQueue = 500;     //!< packets (WifiMacQueue default)
+};
+
+struct FluidResult
+{
+    double cellFramesPerSecond;   //!< saturated DCF capacity, data frames/s
+    double uplinkBps;             //!< payload reaching the AP
+    double p2pBps;                //!< payload crossing the P2P link to the server
+    double echoBps;               //!< replies delivered to the STAs
+    double wifiLoss;              //!< fraction of requests dropped in STA queues
+    double p2pLoss;               //!< fraction of requests reaching the AP dropped at P2P
+    double loss;                  //!< fraction of requests never reaching the server
+    double delay;                 //!< seconds, STA to server (estimate)
+};
+
+/// 802.11a OFDM frame duration: 20 us preamble + 4 us symbols.
+inline double
+OfdmDuration(uint32_t bytes, double rateMbps)
+{
+    const double bitsPerSymbol = rateMbps * 4;
+    return 20e-6 + std::ceil((16 + 6 + 8.0 * bytes) / bitsPerSymbol) * 4e-6;
+}
+
+/**
+ * Bianchi's transmission probability per slot for n saturated stations
+ * with minimum window w and m backoff stages, solved by bisection.
+ */
+inline double
+BianchiTau(uint32_t n, double w, uint32_t m)
+{
+    auto tauOf = [w, m](double p) {
+        return 2 * (1 - 2 * p) / ((1 - 2 * p) * (w + 1) + p * w * (1 - std::pow(2 * p, m)));
+    };
+    double lo = 0;
+    double hi = 1;
+    for (int i = 0; i < 60; i++)
+    {
+        const double tau = (lo + hi) / 2;
+        const double p = 1 - std::pow(1 - tau, n - 1);
+        if (tau > tauOf(p))
+        {
+            hi = tau;
+        }
+        else
+        {
+            lo = tau;
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+/// Successful data frames per second of n saturated 802.11a stations.
+inline double
+DcfFramesPerSecond(uint32_t n, const FluidInput& in)
+{
+    const double slot = 9e-6;
+    const double sifs = 16e-6;
+    const double difs = sifs + 2 * slot;
+    const uint32_t mpdu = in.packetSize + 8 + 20 + 8 + 28; // UDP, IP, LLC, MAC + FCS
+    const double data = OfdmDuration(mpdu, in.dataRateMbps);
+    const double ack = OfdmDuration(14, in.ackRateMbps);
+    // A collision also costs data + EIFS (SIFS + ACK + DIFS).
+    const double exchange = data + sifs + ack + difs;
+
+    const double tau = BianchiTau(std::max<uint32_t>(n, 1), 16, 6);
+    const double pTr = 1 - std::pow(1 - tau, n);
+    const double pS = n * tau * std::pow(1 - tau, n - 1) / pTr;
+    const double slotTime = (1 - pTr) * slot + pTr * exchange;
+    return pTr * pS / slotTime;
+}
+
+/// Max-min fair shares of capacity between demands.
+inline std::vector<double>
+MaxMinShares(const std::vector<double>& demand, double capacity)
+{
+    std::vector<double> share(demand.size(), 0);
+    std::vector<size_t> open;
+    for (size_t i = 0; i < demand.size(); i++)
+    {
+        open.push_back(i);
+    }
+    while (!open.empty() && capacity > 0)
+    {
+        const double fair = capacity / open.size();
+        std::vector<size_t> still;
+        for (size_t i : open)
+        {
+            if (demand[i] - share[i] <= fair)
+            {
+                capacity -= demand[i] - share[i];
+                share[i] = demand[i];
+            }
+            else
+            {
+                still.push_back(i);
+            }
+        }
+        if (still.size() == open.size())
+        {
+            for (size_t i : still)
+            {
+                share[i] += fair;
+            }
+            break;
+        }
+        open.swap(still);
+    }
+    return share;
+}
+
+inline FluidResult
+SolveFluid(const FluidInput& in)
+{
+    FluidResult r;
+    const double bits = 8.0 * in.packetSize;
+    const uint32_t contenders = in.stations + (in.echo ? 1 : 0);
+    r.cellFramesPerSecond = DcfFramesPerSecond(contenders, in);
+
+    // Packets/s: each STA's requests, the AP's replies, the P2P link
+    // (payload + UDP/IP + 2-byte PPP header).
+    const double perSta = in.offeredBps / bits / in.stations;
+    const double p2pPackets = in.p2pBps / (8.0 * (in.packetSize + 8 + 20 + 2));
+    std::vector<double> demand(contenders, perSta);
+    std::vector<double> share;
+    double forward = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        share = MaxMinShares(demand, r.cellFramesPerSecond);
+        double uplink = 0;
+        for (uint32_t s = 0; s < in.stations; s++)
+        {
+            uplink += share[s];
+        }
+        forward = std::min(uplink, p2pPackets);
+        if (!in.echo || std::abs(demand.back() - forward) < 1e-9 * (1 + forward))
+        {
+            break;
+        }
+        demand.back() = forward;
+    }
+    double uplink = 0;
+    for (uint32_t s = 0; s < in.stations; s++)
+    {
+        uplink += share[s];
+    }
+    const double offered = perSta * in.stations;
+    r.uplinkBps = uplink * bits;
+    r.p2pBps = forward * bits;
+    r.echoBps = in.echo ? share.back() * bits : 0;
+    r.wifiLoss = offered > 0 ? std::max(0.0, 1 - uplink / offered) : 0;
+    r.p2pLoss = uplink > 0 ? std::max(0.0, 1 - forward / uplink) : 0;
+    r.loss = offered > 0 ? std::max(0.0, 1 - forward / offered) : 0;
+
+    // Access: one frame exchange plus the mean initial backoff, or a full
+    // STA queue drained at the station's share once it is overloaded.
+    const uint32_t mpdu = in.packetSize + 8 + 20 + 8 + 28;
+    const double access = 34e-6 + 7.5 * 9e-6 + OfdmDuration(mpdu, in.dataRateMbps);
+    const double staRate = in.stations ? share[0] : 0;
+    const double wifiDelay =
+        perSta > staRate * (1 + 1e-9) && staRate > 0 ? in.wifiQueue / staRate : access;
+    const double service = 1 / p2pPackets;
+    const double rho = uplink / p2pPackets;
+    const double p2pWait =
+        rho < 1 ? std::min(rho * service / (2 * (1 - rho)), in.p2pQueue * service)
+                : in.p2pQueue * service;
+    r.delay = wifiDelay + p2pWait + service + in.p2pDelay;
+    return r;
+}
+
+#endif /* FLUID_MODEL_H */
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Calibration du modèle fluide de question2_VariationTopologie (third3).
+
+Parcourt la grille nWifi x {low, medium, high} avec --calibrate : chaque
+point simule le scénario au niveau paquet et ajoute au CSV une ligne avec
+les prédictions du modèle fluide à côté des mesures. Le script affiche
+ensuite l'écart fluide - paquet par point et son résumé pour le débit P2P,
+le débit écho et les pertes.
+"""
+import os
+import subprocess
+import sys
+
+import pandas as pd
+
+NS3_PATH = "/home/ubuntu/ns-allinone-3.45/ns-3.45"
+SCRIPT = "scratch/third3"
+CALIBRATION_FILE = "fluid_calibration.csv"
+NWIFI = [3, 6, 9, 12, 15, 18, 21, 24, 27, 30]
+MODES = ["low", "medium", "high"]
+
+
+def run_grid():
+    path = os.path.join(NS3_PATH, CALIBRATION_FILE)
+    if os.path.exists(path):
+        os.remove(path)
+    for mode in MODES:
+        for nwifi in NWIFI:
+            print(f"  Calibration : mode={mode}, nWifi={nwifi}")
+            cmd = (f"./ns3 run \"{SCRIPT} --mode={mode} --nWifi={nwifi} --verbose=false "
+                   f"--calibrate=true --calibrationFile={CALIBRATION_FILE}\"")
+            result = subprocess.run(cmd, cwd=NS3_PATH, shell=True, capture_output=True, text=True)
+            if result.returncode != 0:
+                print(result.stdout + result.stderr)
+                sys.exit(f"ERREUR : mode={mode}, nWifi={nwifi}")
+    return pd.read_csv(path)
+
+
+def report(df):
+    # Débits en Mbps ; pertes converties en points de pourcentage
+    df["err_p2p_mbps"] = df.fluid_p2p_mbps - df.packet_p2p_mbps
+    df["err_echo_mbps"] = df.fluid_echo_mbps - df.packet_echo_mbps
+    df["err_loss_pts"] = 100 * (df.fluid_loss - df.packet_loss)
+    df["rel_p2p_pct"] = 100 * df.err_p2p_mbps / df.packet_p2p_mbps.where(df.packet_p2p_mbps > 0)
+    df["rel_echo_pct"] = 100 * df.err_echo_mbps / df.packet_echo_mbps.where(df.packet_echo_mbps > 0)
+
+    pd.set_option("display.width", 160)
+    print(df[["nWifi", "mode", "offered_mbps",
+              "fluid_p2p_mbps", "packet_p2p_mbps", "rel_p2p_pct",
+              "fluid_echo_mbps", "packet_echo_mbps", "rel_echo_pct",
+              "err_loss_pts"]].round(3).to_string(index=False))
+
+    print("\nÉcart fluide - paquet par mode (moyenne des |écarts| / pire cas)")
+    for mode, g in df.groupby("mode", sort=False):
+        print(f"  {mode:6s}  P2P {g.err_p2p_mbps.abs().mean():.3f} / {g.err_p2p_mbps.abs().max():.3f} Mbps"
+              f"  écho {g.err_echo_mbps.abs().mean():.3f} / {g.err_echo_mbps.abs().max():.3f} Mbps"
+              f"  pertes {g.err_loss_pts.abs().mean():.2f} / {g.err_loss_pts.abs().max():.2f} pts")
+    df.to_csv("fluid_calibration_errors.csv", index=False)
+    print("\nÉcarts enregistrés dans fluid_calibration_errors.csv")
+
+
+def main():
+    report(run_grid())
+
+
+if __name__ == "__main__":
+    main()
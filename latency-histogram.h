@@ -0,0 +1,143 @@
+/*
+ * Fixed-memory log-linear latency histogram, in the spirit of HdrHistogram.
+ *
+ * Values (nanoseconds) below 2^(SUB_BITS + 1) get one bucket each; above
+ * that, every power of two is split into 2^SUB_BITS equal buckets, so any
+ * recorded value is known to within 1/128 of itself. Recording is a
+ * count-leading-zeros and an increment; histograms with the same layout
+ * merge by adding their counts, so per-flow and per-run histograms can be
+ * combined without keeping samples.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class LatencyHistogram
+{
+  public:
+    static constexpr uint32_t SUB_BITS = 7;  //!< 128 buckets per power of two
+    static constexpr uint32_t MAX_BITS = 44; //!< values up to ~4.9 hours in ns
+
+    LatencyHistogram()
+        : m_counts(BucketCount(), 0)
+    {
+    }
+
+    /// Add one value; values beyond 2^MAX_BITS land in the last bucket.
+    void Record(uint64_t value)
+    {
+        m_counts[Index(std::min(value, MAX_VALUE))]++;
+        m_total++;
+        m_sum += static_cast<double>(value);
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < m_counts.size(); i++)
+        {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    void Reset()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+        m_total = 0;
+        m_sum = 0;
+        m_min = std::numeric_limits<uint64_t>::max();
+        m_max = 0;
+    }
+
+    uint64_t Count() const
+    {
+        return m_total;
+    }
+
+    uint64_t Min() const
+    {
+        return m_total ? m_min : 0;
+    }
+
+    uint64_t Max() const
+    {
+        return m_max;
+    }
+
+    double Mean() const
+    {
+        return m_total ? m_sum / m_total : 0.0;
+    }
+
+    /**
+     * Smallest value v such that at least percentile % of the recorded
+     * values are <= v, reported as the top of its bucket (and never above
+     * the largest recorded value).
+     */
+    uint64_t Percentile(double percentile) const
+    {
+        if (m_total == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * m_total));
+        rank = std::clamp<uint64_t>(rank, 1, m_total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); i++)
+        {
+            seen += m_counts[i];
+            if (seen >= rank)
+            {
+                return std::min(HighestEquivalent(static_cast<uint32_t>(i)), m_max);
+            }
+        }
+        return m_max;
+    }
+
+  private:
+    static constexpr uint64_t HALF = uint64_t(1) << SUB_BITS;
+    static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_BITS) - 1;
+
+    static size_t BucketCount()
+    {
+        return Index(MAX_VALUE) + 1;
+    }
+
+    /// Bucket of v: with e = max(0, msb(v) - SUB_BITS), e * HALF + (v >> e).
+    static uint32_t Index(uint64_t v)
+    {
+        const int msb = v ? 63 - __builtin_clzll(v) : 0;
+        const int e = std::max(0, msb - static_cast<int>(SUB_BITS));
+        return static_cast<uint32_t>(e * HALF + (v >> e));
+    }
+
+    static uint64_t HighestEquivalent(uint32_t index)
+    {
+        if (index < 2 * HALF)
+        {
+            return index;
+        }
+        const uint64_t e = index / HALF - 1;
+        const uint64_t m = index - e * HALF;
+        return ((m + 1) << e) - 1;
+    }
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total = 0;
+    double m_sum = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,274 @@
+/*
+ * Per-packet latency from application tx/rx traces, keyed by packet UID.
+ *
+ * Sent() stamps a UID in an open-addressing table that doubles once half
+ * full, so no packet in flight is ever overwritten however long queues
+ * get; Reached() looks the UID up and records now - send time in the
+ * histogram of the sending flow for that stage, and the last stage frees
+ * the entry. For UDP echo, stage 0 is the server receiving the request
+ * (one way) and stage 1 the client receiving the echo (round trip): the
+ * echo server sends back the same packet, so the UID is kept.
+ *
+ * Optionally the histograms of each interval are also written out as they
+ * complete (streaming mode).
+ */
+
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include "latency-histogram.h"
+
+#include "ns3/application-container.h"
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class LatencyTracker
+{
+  public:
+    /**
+     * stages names the points where packets are matched (e.g. "one-way",
+     * "round-trip"); tableBits sets the initial size of the in-flight table.
+     */
+    explicit LatencyTracker(std::vector<std::string> stages, uint32_t tableBits = 16)
+        : m_stages(std::move(stages)),
+          m_table(size_t(1) << tableBits)
+    {
+    }
+
+    uint32_t AddFlow(const std::string& name)
+    {
+        m_flows.push_back(name);
+        m_total.resize(m_flows.size() * m_stages.size());
+        m_window.resize(m_flows.size() * m_stages.size());
+        return static_cast<uint32_t>(m_flows.size() - 1);
+    }
+
+    void Sent(uint32_t flow, Ptr<const Packet> packet)
+    {
+        if (2 * (m_used + 1) > m_table.size())
+        {
+            Grow();
+        }
+        InFlight& slot = m_table[Find(packet->GetUid())];
+        if (!slot.valid)
+        {
+            slot.uid = packet->GetUid();
+            slot.valid = true;
+            m_used++;
+        }
+        slot.flow = flow;
+        slot.sent = Simulator::Now().GetNanoSeconds();
+    }
+
+    void Reached(uint32_t stage, Ptr<const Packet> packet)
+    {
+        const size_t i = Find(packet->GetUid());
+        const InFlight& slot = m_table[i];
+        if (!slot.valid)
+        {
+            return;
+        }
+        const uint64_t delay = Simulator::Now().GetNanoSeconds() - slot.sent;
+        const size_t h = slot.flow * m_stages.size() + stage;
+        m_total[h].Record(delay);
+        if (m_streaming)
+        {
+            m_window[h].Record(delay);
+        }
+        if (stage + 1 == m_stages.size())
+        {
+            Erase(i);
+        }
+    }
+
+    /// Packets sent and not yet matched at the last stage (lost or in flight).
+    size_t GetInFlight() const
+    {
+        return m_used;
+    }
+
+    /// Trace sinks for MakeBoundCallback (tracker, flow or stage first).
+    static void TraceSent(LatencyTracker* tracker, uint32_t flow, Ptr<const Packet> packet)
+    {
+        tracker->Sent(flow, packet);
+    }
+
+    static void TraceReached(LatencyTracker* tracker, uint32_t stage, Ptr<const Packet> packet)
+    {
+        tracker->Reached(stage, packet);
+    }
+
+    /**
+     * Watch UdpEchoClient i of clients as flow "name i": its Tx starts the
+     * clock, the servers' Rx is stage 0 and the client's Rx stage 1.
+     */
+    void WatchUdpEcho(const ApplicationContainer& clients,
+                      const ApplicationContainer& servers,
+                      const std::string& name)
+    {
+        for (uint32_t i = 0; i < clients.GetN(); i++)
+        {
+            uint32_t flow = AddFlow(name + " " + std::to_string(i));
+            clients.Get(i)->TraceConnectWithoutContext(
+                "Tx",
+                MakeBoundCallback(&LatencyTracker::TraceSent, this, flow));
+            clients.Get(i)->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&LatencyTracker::TraceReached, this, uint32_t(1)));
+        }
+        for (uint32_t i = 0; i < servers.GetN(); i++)
+        {
+            servers.Get(i)->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&LatencyTracker::TraceReached, this, uint32_t(0)));
+        }
+    }
+
+    /**
+     * Every interval, write count, mean, p50, p99, p99.9 and max of each
+     * flow and stage over the elapsed interval to filename.
+     */
+    void StartStreaming(Time interval, const std::string& filename)
+    {
+        m_streaming = true;
+        m_interval = interval;
+        m_out.open(filename);
+        m_out << "time,flow,stage,count,mean_ms,p50_ms,p99_ms,p999_ms,max_ms\n";
+        Simulator::Schedule(m_interval, &LatencyTracker::Tick, this);
+    }
+
+    const LatencyHistogram& GetHistogram(uint32_t flow, uint32_t stage) const
+    {
+        return m_total[flow * m_stages.size() + stage];
+    }
+
+    /// Per-flow and all-flows percentiles of every stage, in ms.
+    void Report(std::ostream& os) const
+    {
+        for (uint32_t s = 0; s < m_stages.size(); s++)
+        {
+            LatencyHistogram all;
+            os << "Latency (" << m_stages[s] << ", ms): count / mean / p50 / p99 / p99.9 / max\n";
+            for (uint32_t f = 0; f < m_flows.size(); f++)
+            {
+                Line(os, m_flows[f], GetHistogram(f, s));
+                all.Merge(GetHistogram(f, s));
+            }
+            Line(os, "all", all);
+        }
+        os << "  unmatched at " << m_stages.back() << " : " << m_used
+           << " (lost or still in flight)\n";
+    }
+
+  private:
+    struct InFlight
+    {
+        uint64_t uid = 0;
+        int64_t sent = 0; //!< ns
+        uint32_t flow = 0;
+        bool valid = false;
+    };
+
+    static void Line(std::ostream& os, const std::string& name, const LatencyHistogram& h)
+    {
+        os << "  " << name << " : " << h.Count() << " / " << h.Mean() / 1e6 << " / "
+           << h.Percentile(50) / 1e6 << " / " << h.Percentile(99) / 1e6 << " / "
+           << h.Percentile(99.9) / 1e6 << " / " << h.Max() / 1e6 << "\n";
+    }
+
+    size_t Home(uint64_t uid) const
+    {
+        return (uid * 0x9e3779b97f4a7c15ULL) >> 20 & (m_table.size() - 1);
+    }
+
+    /// Slot of uid, or the empty slot where it would go.
+    size_t Find(uint64_t uid) const
+    {
+        const size_t mask = m_table.size() - 1;
+        size_t i = Home(uid);
+        while (m_table[i].valid && m_table[i].uid != uid)
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void Grow()
+    {
+        std::vector<InFlight> old(m_table.size() * 2);
+        old.swap(m_table);
+        for (const InFlight& slot : old)
+        {
+            if (slot.valid)
+            {
+                m_table[Find(slot.uid)] = slot;
+            }
+        }
+    }
+
+    /// Free slot i, moving later entries of the probe chain back into it.
+    void Erase(size_t i)
+    {
+        const size_t mask = m_table.size() - 1;
+        for (size_t j = (i + 1) & mask; m_table[j].valid; j = (j + 1) & mask)
+        {
+            // Entry j may fill the hole unless its home lies cyclically in (i, j].
+            const size_t home = Home(m_table[j].uid);
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                m_table[i] = m_table[j];
+                i = j;
+            }
+        }
+        m_table[i].valid = false;
+        m_used--;
+    }
+
+    void Tick()
+    {
+        const double now = Simulator::Now().GetSeconds();
+        for (uint32_t f = 0; f < m_flows.size(); f++)
+        {
+            for (uint32_t s = 0; s < m_stages.size(); s++)
+            {
+                LatencyHistogram& h = m_window[f * m_stages.size() + s];
+                if (h.Count() == 0)
+                {
+                    continue;
+                }
+                m_out << now << "," << m_flows[f] << "," << m_stages[s] << "," << h.Count() << ","
+                      << h.Mean() / 1e6 << "," << h.Percentile(50) / 1e6 << ","
+                      << h.Percentile(99) / 1e6 << "," << h.Percentile(99.9) / 1e6 << ","
+                      << h.Max() / 1e6 << "\n";
+                h.Reset();
+            }
+        }
+        m_out.flush();
+        Simulator::Schedule(m_interval, &LatencyTracker::Tick, this);
+    }
+
+    std::vector<std::string> m_stages;
+    std::vector<std::string> m_flows;
+    std::vector<InFlight> m_table; //!< size a power of two
+    size_t m_used = 0;
+    std::vector<LatencyHistogram> m_total;  //!< [flow * stages + stage]
+    std::vector<LatencyHistogram> m_window; //!< current streaming interval
+    bool m_streaming = false;
+    Time m_interval;
+    std::ofstream m_out;
+};
+
+} // namespace ns3
+
+#endif /* LATENCY_TRACKER_H */
@@ -8,29 +8,61 @@
 #include "ns3/ping-helper.h"
 #include "ns3/position-allocator.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/multi-model-spectrum-channel.h"
+#include "ns3/spectrum-wifi-helper.h"
 #include "ns3/applications-module.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/udp-client-server-helper.h"
 #include "ns3/udp-server.h"
 #include "ns3/mobility-module.h"
-#include "ns3/netanim-module.h"  // Optionnel si tu veux générer un fichier XML pour NetAnim
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <string>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cached-propagation-loss.h"
+#include "flow-metrics.h"
+#include "flow-sampler.h"
+#include "netanim-stream.h"
+#include "neighbor-transmit-filter.h"
+#include "topology-loader.h"
+#include "traffic-matrix.h"
 
 using namespace ns3;
 using namespace std;
 
+/// Metrics of one simulated point, as printed by Report ().
+struct RunResult
+{
+  uint32_t size;
+  double txrange;
+  uint32_t run;
+  uint64_t lostPackets;
+  double throughput;   //!< Kbps (1000 bits/s)
+  double pdr;          //!< percent
+  double fairness;     //!< Jain's index over per-flow throughputs
+};
+
 class AodvExample
 {
 public:
   AodvExample ();
   bool Configure (int argc, char **argv);
   void Run ();
+  void Sweep ();
   void Report (std::ostream & os);
 
+  bool IsSweep () const;
+
 private:
   uint32_t size;
   double step;
@@ -39,6 +71,7 @@ private:
   bool printRoutes;
 
   std::string topology = "scratch/manet100.csv";
+  std::string trafficFile;
   double txrange = 50;
   uint32_t interval = 10;
   bool verbose = false;
@@ -46,11 +79,31 @@ private:
 
   std::string outputFilename = "manet"; // <-- fixed
 
+  // Sweep lists; any of them turns on the in-process sweep.
+  std::string sizes;
+  std::string txranges;
+  std::string runs;
+  std::string sweepFile = "manet_sweep.csv";
+  uint32_t replications = 0;
+  uint32_t jobs = 0;
+  std::string summaryFile = "manet_summary.csv";
+  std::string channel = "yans";
+  bool cacheLoss = false;
+  double sampleInterval = 0;
+  std::string sampleFile = "manet_samples.csv";
+  std::string metricsFile = "manet_metrics.json";
+  std::vector<double> phaseStarts;   //!< start of load phase k at [k - 1]
+  bool animation = false;
+  uint32_t animSample = 1;
+  bool animGzip = false;
+  RunResult result;
+
   NodeContainer nodes;
   NetDeviceContainer devices;
   Ipv4InterfaceContainer interfaces;
-  Address serverAddress[50];
+  TrafficMatrix traffic;
   YansWifiPhyHelper wifiPhy ;
+  SpectrumWifiPhyHelper spectrumPhy;
   WifiMacHelper wifiMac;
 
 private:
@@ -58,8 +111,53 @@ private:
   void CreateDevices ();
   void InstallInternetStack ();
   void InstallApplications ();
+  void Simulate ();
+  void Teardown ();
+  WifiPhyHelper &Phy ();
+  void RunPoint (RunResult &point);
+  void RunForked (std::vector<RunResult> &points, uint32_t workers);
+  void Summarize (const std::vector<RunResult> &points, std::ostream &table);
 };
 
+// Parse "10,20,30" into values; false on an empty or malformed list.
+template <typename T>
+static bool
+ParseList (const std::string &list, std::vector<T> &values)
+{
+  values.clear ();
+  const char *p = list.data ();
+  const char *end = p + list.size ();
+  while (p < end)
+  {
+    T v;
+    if (!CsvParseField (p, end, v))
+      return false;
+    values.push_back (v);
+  }
+  return !values.empty ();
+}
+
+// Two-sided 95% Student t quantile for df degrees of freedom.
+static double
+StudentT95 (uint32_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (df == 0)
+    return 0;
+  if (df <= 30)
+    return table[df - 1];
+  if (df <= 40)
+    return 2.021;
+  if (df <= 60)
+    return 2.000;
+  if (df <= 120)
+    return 1.980;
+  return 1.960;
+}
+
 NS_LOG_COMPONENT_DEFINE ("ManetTest");
 
 int main (int argc, char **argv)
@@ -68,6 +166,11 @@ int main (int argc, char **argv)
   if (!test.Configure (argc, argv))
     NS_FATAL_ERROR ("Configuration failed. Aborted.");
 
+  if (test.IsSweep ())
+  {
+    test.Sweep ();
+    return 0;
+  }
   test.Run ();
   test.Report (std::cout);
   return 0;
@@ -94,13 +197,35 @@ AodvExample::Configure (int argc, char **argv)
   cmd.AddValue ("simTime", "Simulation time, in seconds.", simTime);
   cmd.AddValue ("outputFilename", "Output filename", outputFilename); // <-- string
   cmd.AddValue ("topology", "Topology file.", topology);
+  cmd.AddValue ("traffic", "Traffic matrix CSV replacing the staged pairs (nodes by index).", trafficFile);
   cmd.AddValue ("txrange", "Transmission range per node, in meters.", txrange);
   cmd.AddValue ("interval", "Interval between each iteration.", interval);
   cmd.AddValue ("verbose", "Verbose tracking.", verbose);
   cmd.AddValue ("tracing", "Enable pcap tracing", tracing);
+  cmd.AddValue ("sizes", "Sweep: comma-separated node counts (default: size).", sizes);
+  cmd.AddValue ("txranges", "Sweep: comma-separated transmission ranges (default: txrange).", txranges);
+  cmd.AddValue ("runs", "Sweep: comma-separated RngRun values (default: 1).", runs);
+  cmd.AddValue ("sweepFile", "Sweep: CSV file receiving one row per point.", sweepFile);
+  cmd.AddValue ("replications", "Sweep: RngRun values 1..N per point (unless --runs).", replications);
+  cmd.AddValue ("jobs", "Sweep: points simulated at once, each in its own process (0 = one per core).", jobs);
+  cmd.AddValue ("channel", "Wifi channel: yans, or neighbor to deliver only to in-range nodes.", channel);
+  cmd.AddValue ("cacheLoss", "Memoize the propagation loss per node pair.", cacheLoss);
+  cmd.AddValue ("sampleInterval", "Per-flow time series period, in seconds (0 = off).", sampleInterval);
+  cmd.AddValue ("sampleFile", "Per-flow time series CSV file.", sampleFile);
+  cmd.AddValue ("summaryFile", "Sweep: CSV of per-point means and 95% confidence intervals.", summaryFile);
+  cmd.AddValue ("metricsFile", "JSON per-flow, per-phase and total metrics (empty = none).", metricsFile);
+  cmd.AddValue ("animation", "Write a NetAnim file (manet-28.xml).", animation);
+  cmd.AddValue ("animSample", "NetAnim: draw one packet in N.", animSample);
+  cmd.AddValue ("animGzip", "NetAnim: compress the file through gzip.", animGzip);
 
   cmd.Parse (argc, argv);
 
+  if (channel != "yans" && channel != "neighbor")
+  {
+    std::cerr << "Unknown channel " << channel << " (yans or neighbor).\n";
+    return false;
+  }
+
   if (verbose)
   {
     LogComponentEnable ("UdpSocket", LOG_LEVEL_INFO);
@@ -110,23 +235,220 @@ AodvExample::Configure (int argc, char **argv)
   return true;
 }
 
+bool
+AodvExample::IsSweep () const
+{
+  return !sizes.empty () || !txranges.empty () || !runs.empty () || replications > 0;
+}
+
 void
 AodvExample::Run ()
 {
+  result.size = size;
+  result.txrange = txrange;
+  result.run = RngSeedManager::GetRun ();
+
   CreateNodes ();
   CreateDevices ();
   InstallInternetStack ();
   InstallApplications ();
+  Simulate ();
+  Teardown ();
+}
 
-  Simulator::Stop (Seconds (simTime));
-  Simulator::Run ();
-  Simulator::Destroy ();
+void
+AodvExample::Report (std::ostream &os)
+{
+  os << "\n\n";
+  os << "  Total Packets Lost: " << result.lostPackets << "\n";
+  os << "  Throughput: " << result.throughput << " Kbps" << "\n";
+  os << "  Packets Delivery Ratio: " << result.pdr << "%" << "\n";
+  os << "  Jain Fairness Index: " << result.fairness << "\n";
+}
+
+void
+AodvExample::Sweep ()
+{
+  std::vector<uint32_t> sizeList;
+  std::vector<double> txrangeList;
+  std::vector<uint32_t> runList;
+  if (!ParseList (sizes.empty () ? std::to_string (size) : sizes, sizeList) ||
+      !ParseList (txranges.empty () ? std::to_string (txrange) : txranges, txrangeList) ||
+      (!runs.empty () && !ParseList (runs, runList)))
+  {
+    NS_FATAL_ERROR ("Malformed --sizes, --txranges or --runs list.");
+  }
+  if (runList.empty ())
+  {
+    for (uint32_t run = 1; run <= std::max (replications, 1u); ++run)
+      runList.push_back (run);
+  }
+
+  // Replications innermost, so the rows of a (size, txrange) point are
+  // adjacent in the CSV.
+  std::vector<RunResult> points;
+  for (uint32_t s : sizeList)
+    for (double r : txrangeList)
+      for (uint32_t run : runList)
+        points.push_back ({s, r, run, 0, 0, 0, 0});
+
+  // Per-point pcap, trace, sample, metrics and animation files would
+  // overwrite each other.
+  pcap = false;
+  tracing = false;
+  animation = false;
+  sampleInterval = 0;
+  metricsFile.clear ();
+
+  // Even with one job every point runs in a fresh child, so that it draws
+  // the same random streams as a standalone --size/--txrange run.
+  uint32_t workers = jobs ? jobs : std::max (1u, std::thread::hardware_concurrency ());
+  workers = std::min<uint32_t> (workers, points.size ());
+  RunForked (points, workers);
+
+  std::ofstream out (sweepFile);
+  out << "num_nodes,tx_range,run,packets_lost,throughput,pdr,fairness\n";
+  for (const RunResult &p : points)
+  {
+    out << p.size << "," << p.txrange << "," << p.run << ","
+        << p.lostPackets << "," << p.throughput << "," << p.pdr << "," << p.fairness << "\n";
+  }
+  std::cout << "Wrote " << points.size () << " points to " << sweepFile << ".\n";
+
+  if (runList.size () > 1)
+    Summarize (points, std::cout);
+}
+
+void
+AodvExample::RunPoint (RunResult &point)
+{
+  size = point.size;
+  txrange = point.txrange;
+  RngSeedManager::SetRun (point.run);
+  Run ();
+  point = result;
+}
+
+void
+AodvExample::RunForked (std::vector<RunResult> &points, uint32_t workers)
+{
+  // Every point gets a fresh child: ns-3 hands out automatic RNG stream
+  // indices from a process-wide counter that Simulator::Destroy () never
+  // resets, so a process reused for a second point would draw different
+  // streams. Nothing ns-3 has run in this process yet, so each child starts
+  // from zero like a standalone run, whatever the number of workers.
+  // At most workers children run at once; each writes one (index, result)
+  // record to its own pipe, far below PIPE_BUF, and exits.
+  struct Record
+  {
+    uint64_t index;
+    RunResult result;
+  };
+  struct Child
+  {
+    pid_t pid;
+    int fd;
+  };
+
+  std::cout.flush ();
+  std::vector<Child> running;
+  size_t received = 0;
+  auto reap = [&points, &running, &received] ()
+  {
+    int status = 0;
+    pid_t pid = waitpid (-1, &status, 0);
+    auto child = std::find_if (running.begin (), running.end (),
+                               [pid] (const Child &c) { return c.pid == pid; });
+    if (child == running.end ())
+      NS_FATAL_ERROR ("Unexpected child " << pid << ".");
+    Record record;
+    bool ok = WIFEXITED (status) && WEXITSTATUS (status) == 0 &&
+              read (child->fd, &record, sizeof (record)) == sizeof (record);
+    close (child->fd);
+    running.erase (child);
+    if (!ok)
+      NS_FATAL_ERROR ("Worker " << pid << " failed.");
+    points[record.index] = record.result;
+    received++;
+  };
+
+  for (size_t i = 0; i < points.size (); ++i)
+  {
+    if (running.size () == workers)
+      reap ();
+    int fd[2];
+    if (pipe (fd) != 0)
+      NS_FATAL_ERROR ("Cannot create a pipe for point " << i << ".");
+    pid_t pid = fork ();
+    if (pid < 0)
+      NS_FATAL_ERROR ("Cannot fork point " << i << ".");
+    if (pid == 0)
+    {
+      close (fd[0]);
+      for (const Child &other : running)
+        close (other.fd);
+      RunPoint (points[i]);
+      Record record = {i, points[i]};
+      std::cout.flush ();
+      _exit (write (fd[1], &record, sizeof (record)) == sizeof (record) ? 0 : 1);
+    }
+    close (fd[1]);
+    running.push_back ({pid, fd[0]});
+  }
+  while (!running.empty ())
+    reap ();
+  if (received != points.size ())
+    NS_FATAL_ERROR ("Workers returned " << received << " of " << points.size () << " points.");
 }
 
 void
-AodvExample::Report (std::ostream &)
+AodvExample::Summarize (const std::vector<RunResult> &points, std::ostream &table)
 {
-  // optional reporting
+  std::ofstream out (summaryFile);
+  out << "num_nodes,tx_range,replications,packets_lost_mean,packets_lost_ci95,"
+      << "throughput_mean,throughput_ci95,pdr_mean,pdr_ci95,fairness_mean,fairness_ci95\n";
+  table << "\n  nodes  txrange  reps       lost (95% CI)       throughput Kbps (95% CI)     PDR % (95% CI)"
+        << "     fairness (95% CI)\n";
+
+  // Points of one (size, txrange) pair are contiguous.
+  for (size_t begin = 0, end; begin < points.size (); begin = end)
+  {
+    end = begin;
+    while (end < points.size () && points[end].size == points[begin].size &&
+           points[end].txrange == points[begin].txrange)
+      ++end;
+
+    const uint32_t n = end - begin;
+    double mean[4] = {0, 0, 0, 0};
+    double ci[4] = {0, 0, 0, 0};
+    auto metric = [&points] (size_t i, int m) -> double {
+      return m == 0 ? points[i].lostPackets : m == 1 ? points[i].throughput
+           : m == 2 ? points[i].pdr : points[i].fairness;
+    };
+    for (int m = 0; m < 4; ++m)
+    {
+      for (size_t i = begin; i < end; ++i)
+        mean[m] += metric (i, m) / n;
+      double var = 0;
+      for (size_t i = begin; i < end; ++i)
+        var += (metric (i, m) - mean[m]) * (metric (i, m) - mean[m]);
+      if (n > 1)
+        ci[m] = StudentT95 (n - 1) * std::sqrt (var / (n - 1) / n);
+    }
+
+    out << points[begin].size << "," << points[begin].txrange << "," << n;
+    for (int m = 0; m < 4; ++m)
+      out << "," << mean[m] << "," << ci[m];
+    out << "\n";
+
+    char line[200];
+    snprintf (line, sizeof (line), "  %5u  %7.1f  %4u  %9.1f +- %-8.1f  %12.3f +- %-10.3f  %6.2f +- %-6.2f"
+              "  %6.3f +- %-6.3f\n",
+              points[begin].size, points[begin].txrange, n,
+              mean[0], ci[0], mean[1], ci[1], mean[2], ci[2], mean[3], ci[3]);
+    table << line;
+  }
+  table << "Wrote per-point means and confidence intervals to " << summaryFile << ".\n";
 }
 
 void
@@ -144,35 +466,27 @@ AodvExample::CreateNodes ()
 
   Ptr<ListPositionAllocator> positionAllocS = CreateObject<ListPositionAllocator> ();
 
-  std::string line;
-  ifstream file(topology);
-  uint16_t i = 0;
-  double vec[3];
-
-  if(file.is_open())
+  // Binary topologies are read straight from the mapping, z included.
+  TopologyView view;
+  Topology topo;
+  std::string error;
+  if (view.Open (topology))
   {
-    while(getline(file,line))
+    for (size_t n = 0; n < view.Size (); ++n)
     {
-      char seps[] = ",";
-      char *token = strtok(&line[0], seps);
-
-      while(token != NULL)
-      {
-        vec[i] = atof(token);
-        i++;
-        token = strtok (NULL, ",");
-        if(i == 3)
-        {
-          positionAllocS->Add(Vector(vec[1], vec[2], 0.0));
-          i = 0;
-        }
-      }
+      positionAllocS->Add (Vector (view.X (n), view.Y (n), view.Z (n)));
+    }
+  }
+  else if (LoadTopology (topology, topo, &error))
+  {
+    for (size_t n = 0; n < topo.Size (); ++n)
+    {
+      positionAllocS->Add (Vector (topo.x[n], topo.y[n], topo.z.empty () ? 0.0 : topo.z[n]));
     }
-    file.close();
   }
   else
   {
-    std::cout<<"Error in csv file"<< '\n';
+    std::cout << "Error in csv file: " << error << '\n';
   }
 
   MobilityHelper mobilityS;
@@ -186,22 +500,66 @@ AodvExample::CreateDevices ()
 {
   wifiMac.SetType ("ns3::AdhocWifiMac");
 
-  YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
-  wifiChannel.AddPropagationLoss("ns3::RangePropagationLossModel",
-                                "MaxRange", DoubleValue (txrange));
-  wifiPhy.SetChannel (wifiChannel.Create ());
   WifiHelper wifi;
   wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
                                 "DataMode", StringValue ("OfdmRate6Mbps"),
                                 "RtsCtsThreshold", UintegerValue (0));
-  devices = wifi.Install (wifiPhy, wifiMac, nodes);
+
+  // Same loss chain as the Yans default helper plus the range cut-off.
+  Ptr<PropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<RangePropagationLossModel> range = CreateObject<RangePropagationLossModel> ();
+  range->SetAttribute ("MaxRange", DoubleValue (txrange));
+  loss->SetNext (range);
+  if (cacheLoss)
+  {
+    // Nodes are static: evaluate the chain once per pair.
+    loss = CreateCachedLoss (loss);
+  }
+
+  if (channel == "neighbor")
+  {
+    // A spectrum channel whose transmit filter drops receivers out of
+    // txrange before any loss is computed. Nodes are static, so the lists
+    // are built once.
+    Ptr<MultiModelSpectrumChannel> spectrumChannel = CreateObject<MultiModelSpectrumChannel> ();
+    spectrumChannel->AddPropagationLossModel (loss);
+    spectrumChannel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+    Ptr<NeighborListTransmitFilter> filter = CreateObject<NeighborListTransmitFilter> ();
+    filter->Build (nodes, txrange);
+    spectrumChannel->AddSpectrumTransmitFilter (filter);
+
+    spectrumPhy.SetChannel (spectrumChannel);
+    devices = wifi.Install (spectrumPhy, wifiMac, nodes);
+  }
+  else
+  {
+    YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
+    wifiChannel.AddPropagationLoss("ns3::RangePropagationLossModel",
+                                  "MaxRange", DoubleValue (txrange));
+    Ptr<YansWifiChannel> yansChannel = wifiChannel.Create ();
+    if (cacheLoss)
+    {
+      yansChannel->SetPropagationLossModel (loss);
+    }
+    wifiPhy.SetChannel (yansChannel);
+    devices = wifi.Install (wifiPhy, wifiMac, nodes);
+  }
 
   if (pcap)
   {
-    wifiPhy.EnablePcapAll (outputFilename);
+    Phy ().EnablePcapAll (outputFilename);
   }
 }
 
+WifiPhyHelper &
+AodvExample::Phy ()
+{
+  if (channel == "neighbor")
+    return spectrumPhy;
+  return wifiPhy;
+}
+
 void
 AodvExample::InstallInternetStack ()
 {
@@ -213,94 +571,122 @@ AodvExample::InstallInternetStack ()
   Ipv4AddressHelper address;
   address.SetBase ("10.0.0.0", "255.0.0.0");
   interfaces = address.Assign (devices);
-
-  for(uint32_t i = 0; i < (size / 2); i++)
-  {
-    serverAddress[i] = Address (interfaces.GetAddress (i));
-  }
 }
 
 void
 AodvExample::InstallApplications ()
 {
-  uint16_t i, j, k;
   uint16_t port = 4000;
-  UdpServerHelper server (port);
-  ApplicationContainer apps;
-
-  for(i = 0; i < (size / 2); i++)
-  {
-    apps = server.Install (nodes.Get (i));
-  }
-  apps.Start (Seconds (1.0));
-  apps.Stop (Seconds (simTime));
-
   uint32_t MaxPacketSize = 1024;
   Time interPacketInterval = Seconds (0.01);
   uint32_t maxPacketCount = 3;
   double interval_start = 2.0, interval_end = interval_start + interval;
 
-  for(k = 1; k <= (size / 2); k++)
+  phaseStarts.clear ();
+  if (!trafficFile.empty ())
+  {
+    std::string error;
+    if (!LoadTrafficMatrix (trafficFile, traffic, &error))
+      NS_FATAL_ERROR ("Error in traffic file: " << error);
+    traffic.Install (nodes, port, Seconds (1.0), Seconds (simTime));
+    return;
+  }
+
+  // Load phase k runs k pairs side by side: node size/2 + i sends to
+  // node i, for i < k.
+  const uint32_t pairs = size / 2;
+  traffic.Clear ();
+  traffic.Reserve (pairs * (pairs + 1) / 2);
+  for (uint32_t k = 1; k <= pairs; k++)
   {
-    for(i = 0; i < k; i++)
+    phaseStarts.push_back (interval_start);
+    for (uint32_t i = 0; i < k; i++)
     {
-      UdpClientHelper client (serverAddress[i], port);
-      client.SetAttribute ("MaxPackets", UintegerValue (maxPacketCount));
-      client.SetAttribute ("Interval", TimeValue (interPacketInterval));
-      client.SetAttribute ("PacketSize", UintegerValue (MaxPacketSize));
-      for(j = (size / 2); j < ((size / 2) + k); j++)
-      {
-        apps = client.Install (nodes.Get (j));
-      }
+      traffic.Add ({pairs + i, i, Seconds (interval_start), Seconds (interval_end),
+                    interPacketInterval, MaxPacketSize, maxPacketCount});
     }
-    apps.Start (Seconds (interval_start));
-    apps.Stop (Seconds (interval_end));
     interval_start = interval_end + 1.0;
     interval_end = interval_start + interval;
   }
+  traffic.Install (nodes, port, Seconds (1.0), Seconds (simTime));
+}
 
+void
+AodvExample::Simulate ()
+{
   FlowMonitorHelper flowmon;
   Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
-  Simulator::Stop (Seconds (10.0));
+  // Load phase k (k active pairs) is tagged in the per-flow time series.
+  FlowSampler sampler;
+  if (sampleInterval > 0)
+  {
+    sampler.Start (monitor, Seconds (sampleInterval), sampleFile);
+    for (size_t k = 0; k < phaseStarts.size (); ++k)
+      Simulator::Schedule (Seconds (phaseStarts[k]), &FlowSampler::SetPhase, &sampler, k + 1);
+  }
+
+  // The scenario has always stopped at 10 s; simTime only bounds the servers.
+  // A traffic file may run longer.
+  Time stop = Seconds (10.0);
+  if (!trafficFile.empty ())
+    stop = std::max (stop, traffic.GetEnd () + Seconds (1.0));
+  Simulator::Stop (stop);
 
   if (tracing)
   {
-    wifiPhy.EnablePcapAll (outputFilename);
+    Phy ().EnablePcapAll (outputFilename);
 
   }
-  AnimationInterface anim("manet-28.xml"); // Génère un fichier XML pour NetAnim
+  std::unique_ptr<StreamingAnimation> anim;
+  if (animation)
+  {
+    anim = std::make_unique<StreamingAnimation> ();
+    anim->SetSampling (animSample);
+    anim->Open ("manet-28.xml", animGzip); // Génère un fichier XML pour NetAnim
+  }
   Simulator::Run ();
-
-  monitor->CheckForLostPackets ();
-
-  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
-  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
-
-  uint32_t rxPacketsum = 0, txPacketsum = 0, txBytessum = 0, rxBytessum = 0, lostPacketssum = 0;
-  double Delaysum = 0;
-  uint32_t txTimeFirst = 0, rxTimeLast = 0;
-  k = 0;
-
-  for (auto i = stats.begin (); i != stats.end (); ++i)
+  if (anim)
   {
-    Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
-    rxPacketsum += i->second.rxPackets;
-    txPacketsum += i->second.txPackets;
-    txBytessum += i->second.txBytes;
-    rxBytessum += i->second.rxBytes;
-    Delaysum += i->second.delaySum.GetSeconds();
-    lostPacketssum += i->second.lostPackets;
-    txTimeFirst += i->second.timeFirstTxPacket.GetSeconds();
-    rxTimeLast += i->second.timeLastRxPacket.GetSeconds();
+    anim->Close ();
+    std::cout << "NetAnim: " << anim->GetFilename () << ", " << anim->GetPackets () << " packets\n";
+  }
+  sampler.Flush ();
+
+  // Flows are assigned to the load phase their first packet was sent in.
+  FlowMetrics metrics;
+  std::vector<Time> starts;
+  for (double start : phaseStarts)
+    starts.push_back (Seconds (start));
+  metrics.SetPhases (starts);
+  metrics.Collect (monitor, DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ()));
+
+  const FlowMetrics::Totals &total = metrics.GetTotals ();
+  result.lostPackets = total.lostPackets;
+  result.throughput = total.ThroughputKbps ();
+  result.pdr = total.Pdr ();
+  result.fairness = total.fairness;
+
+  if (!metricsFile.empty ())
+  {
+    std::ofstream out (metricsFile);
+    out << "{\"nodes\": " << size << ", \"txrange\": " << txrange << ", \"run\": " << result.run
+        << ", \"metrics\": ";
+    metrics.WriteJson (out);
+    out << "}\n";
   }
-
-  uint64_t timeDiff = (rxTimeLast - txTimeFirst);
-
-  std::cout << "\n\n";
-  std::cout << "  Total Packets Lost: " << lostPacketssum << "\n";
-  std::cout << "  Throughput: " << ((rxBytessum * 8.0) / timeDiff)/1024<<" Kbps"<<"\n";
-  std::cout << "  Packets Delivery Ratio: " << (((txPacketsum - lostPacketssum) * 100) /txPacketsum) << "%" << "\n";
 
   Simulator::Destroy ();
 }
+
+void
+AodvExample::Teardown ()
+{
+  // Leave nothing behind for the next point of a sweep: node names and
+  // allocated addresses outlive Simulator::Destroy ().
+  Names::Clear ();
+  Ipv4AddressGenerator::Reset ();
+  nodes = NodeContainer ();
+  devices = NetDeviceContainer ();
+  interfaces = Ipv4InterfaceContainer ();
+}
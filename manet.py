@@ -68,6 +68,31 @@ class MANETSimulator:
             if result:
                 self.results.append(result)
 
+    def run_sweep(self, node_list, tx_range=50, sim_time=50, sweep_file='manet_sweep.csv'):
+        # Un seul lancement ns-3 pour toute la liste : manet-28 écrit une
+        # ligne CSV par point au lieu d'un rapport texte à parser. Chaque
+        # point tourne dans un processus fils neuf, avec les mêmes flux
+        # aléatoires qu'un lancement --size seul : les résultats restent
+        # comparables à ceux de run_simulation.
+        sizes = ",".join(str(n) for n in node_list)
+        cmd = [
+            './ns3', 'run',
+            f'"{self.script_name} --sizes={sizes} --txranges={tx_range} '
+            f'--simTime={sim_time} --sweepFile={sweep_file}"'
+        ]
+        result = subprocess.run(" ".join(cmd), cwd=self.ns3_path, shell=True)
+        if result.returncode != 0:
+            print(f"ERREUR : ns-3 a retourné {result.returncode}")
+            return
+        df = pd.read_csv(os.path.join(self.ns3_path, sweep_file))
+        for row in df.itertuples():
+            self.results.append({
+                'num_nodes': row.num_nodes,
+                'packets_lost': row.packets_lost,
+                'throughput': row.throughput,
+                'pdr': row.pdr
+            })
+
     def save_results(self):
         df = pd.DataFrame(self.results)
         df.to_csv("manet_results.csv", index=False)
@@ -120,7 +145,7 @@ def main():
     # Liste des tailles à simuler
     node_list = list(range(10, 101, 10))  # 10 → 100
 
-    sim.run_multiple(node_list)
+    sim.run_sweep(node_list)
     sim.save_results()
     sim.plot_results()
 
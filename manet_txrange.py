@@ -113,6 +113,32 @@ class MANETSimulatorTxRange:
         print("SIMULATIONS TERMINÉES")
         print("="*70)
     
+    def run_sweep(self, tx_range_list, num_nodes=50, sim_time=50, sweep_file='manet_txrange_sweep.csv'):
+        """
+        Exécute toutes les portées en un seul lancement ns-3 (--txranges)
+        et relit le CSV écrit par manet-28. Chaque point tourne dans un
+        processus fils neuf : mêmes résultats qu'un lancement --txrange seul.
+        """
+        txranges = ",".join(str(r) for r in tx_range_list)
+        cmd = [
+            './ns3', 'run',
+            f'"{self.script_name} --sizes={num_nodes} --txranges={txranges} '
+            f'--simTime={sim_time} --sweepFile={sweep_file}"'
+        ]
+        result = subprocess.run(" ".join(cmd), cwd=self.ns3_path, shell=True)
+        if result.returncode != 0:
+            print(f"✗ Erreur: ns-3 a retourné {result.returncode}")
+            return
+        df = pd.read_csv(os.path.join(self.ns3_path, sweep_file))
+        for row in df.itertuples():
+            self.results.append({
+                'tx_range': row.tx_range,
+                'num_nodes': row.num_nodes,
+                'packets_lost': row.packets_lost,
+                'throughput': row.throughput,
+                'pdr': row.pdr
+            })
+    
     def save_results(self, filename='manet_txrange_results.csv'):
         """Sauvegarde les résultats dans un CSV"""
         if not self.results:
@@ -391,7 +417,7 @@ def main():
     input("\n▶️  Appuyez sur Entrée pour démarrer...")
     
     # Exécution des simulations
-    simulator.run_multiple(tx_range_list, num_nodes=NUM_NODES)
+    simulator.run_sweep(tx_range_list, num_nodes=NUM_NODES)
     
     # Sauvegarde et analyse
     simulator.save_results('manet_txrange_results.csv')
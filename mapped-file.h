@@ -0,0 +1,108 @@
+/*
+ * Read-only view of a whole file: mmap'd where the platform allows it,
+ * otherwise read into one heap block.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    bool Open(const std::string& path)
+    {
+        Close();
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            m_size = static_cast<size_t>(st.st_size);
+            if (m_size == 0)
+            {
+                ::close(fd);
+                m_data = "";
+                return true;
+            }
+            void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                ::madvise(p, m_size, MADV_SEQUENTIAL);
+                ::close(fd);
+                m_map = p;
+                m_data = static_cast<const char*>(p);
+                return true;
+            }
+        }
+        ::close(fd);
+#endif
+        // Pipes, special files or no mmap: one large read.
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        m_size = m_buffer.size();
+        m_data = m_buffer.data();
+        return true;
+    }
+
+    void Close()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (m_map)
+        {
+            ::munmap(m_map, m_size);
+        }
+#endif
+        m_map = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+        m_buffer.clear();
+    }
+
+    const char* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+  private:
+    void* m_map = nullptr;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    std::vector<char> m_buffer;
+};
+
+#endif /* MAPPED_FILE_H */
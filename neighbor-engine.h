@@ -0,0 +1,159 @@
+/*
+ * Parallel neighbor counting over a SpatialGrid.
+ *
+ * Work is handed out as chunks of consecutive grid cells, so each worker
+ * scans nodes that are close in memory and in space. Workers pull chunks
+ * from a shared atomic cursor, write the counts of their own nodes (no two
+ * workers touch the same node) and keep private totals that are merged once
+ * they have joined.
+ */
+
+#ifndef NEIGHBOR_ENGINE_H
+#define NEIGHBOR_ENGINE_H
+
+#include "spatial-grid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * Run fn(worker) on `threads` workers (0 = one per hardware thread) and
+ * wait for all of them. Worker 0 runs on the calling thread.
+ */
+template <typename F>
+inline void
+RunWorkers(uint32_t threads, F fn)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (uint32_t t = 1; t < threads; t++)
+    {
+        pool.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (auto& worker : pool)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * Call fn(worker, cellBegin, cellEnd) on chunks of cells until the grid is
+ * covered.
+ */
+template <typename F>
+inline void
+ForEachCellChunk(const SpatialGrid& grid, uint32_t threads, F fn)
+{
+    const uint32_t cells = grid.GetCellCount();
+    const uint32_t chunk = 64;
+    std::atomic<uint32_t> cursor{0};
+    RunWorkers(threads, [&](uint32_t worker) {
+        for (;;)
+        {
+            uint32_t begin = cursor.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin >= cells)
+            {
+                break;
+            }
+            fn(worker, begin, std::min(begin + chunk, cells));
+        }
+    });
+}
+
+/// Totals for one radius, merged from the per-worker counters.
+struct NeighborTotals
+{
+    uint64_t sum = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t isolated = 0;
+
+    void Add(uint32_t c)
+    {
+        sum += c;
+        min = std::min(min, c);
+        max = std::max(max, c);
+        isolated += (c == 0);
+    }
+
+    void Merge(const NeighborTotals& o)
+    {
+        sum += o.sum;
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        isolated += o.isolated;
+    }
+};
+
+/**
+ * Neighbors of every node within each of the nr ascending radii, excluding
+ * the node itself: counts[id * nr + k] for node id and radii[k]. The grid
+ * must have been built with a cell size of at least radii[nr - 1]. Returns
+ * the per-radius totals.
+ */
+inline std::vector<NeighborTotals>
+CountNeighbors(const SpatialGrid& grid,
+               const double* radii,
+               uint32_t nr,
+               uint32_t threads,
+               std::vector<uint32_t>& counts)
+{
+    const uint32_t n = grid.GetN();
+    counts.assign(static_cast<size_t>(n) * nr, 0);
+    std::vector<double> r2(nr);
+    for (uint32_t k = 0; k < nr; k++)
+    {
+        r2[k] = radii[k] * radii[k];
+    }
+
+    uint32_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::vector<NeighborTotals>> local(workers, std::vector<NeighborTotals>(nr));
+
+    ForEachCellChunk(grid, workers, [&](uint32_t worker, uint32_t cellBegin, uint32_t cellEnd) {
+        std::vector<NeighborTotals>& totals = local[worker];
+        for (uint32_t s = grid.CellBegin(cellBegin); s < grid.CellBegin(cellEnd); s++)
+        {
+            uint32_t* c = &counts[static_cast<size_t>(grid.GetId(s)) * nr];
+            if (nr == 1)
+            {
+                // the node itself is indexed too
+                c[0] = grid.CountWithin(grid.GetX(s), grid.GetY(s), radii[0]) - 1;
+            }
+            else
+            {
+                // Each pair lands in the bin of the smallest radius covering
+                // it; a prefix sum over the bins gives every radius.
+                grid.BinWithin(grid.GetX(s), grid.GetY(s), r2.data(), nr, c);
+                c[0]--;
+                for (uint32_t k = 1; k < nr; k++)
+                {
+                    c[k] += c[k - 1];
+                }
+            }
+            for (uint32_t k = 0; k < nr; k++)
+            {
+                totals[k].Add(c[k]);
+            }
+        }
+    });
+
+    std::vector<NeighborTotals> totals(nr);
+    for (const auto& l : local)
+    {
+        for (uint32_t k = 0; k < nr; k++)
+        {
+            totals[k].Merge(l[k]);
+        }
+    }
+    return totals;
+}
+
+#endif /* NEIGHBOR_ENGINE_H */
@@ -0,0 +1,240 @@
+/*
+ * Incremental neighbor sets over a mobility trace.
+ *
+ * Nodes live in a hashed grid of radius-wide cells. Each frame only touches
+ * the nodes whose position changed: a node is rehashed when it crosses a
+ * cell border, its neighbor set is recomputed from the 3x3 cells around it,
+ * and the difference with the previous set is reported as link up/down
+ * events. Per-frame cost is O(moved nodes x local density) instead of a
+ * full O(N^2) recount.
+ */
+
+#ifndef NEIGHBOR_TRACKER_H
+#define NEIGHBOR_TRACKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct LinkEvent
+{
+    uint32_t a; //!< lower node id
+    uint32_t b; //!< higher node id
+    bool up;
+};
+
+class NeighborTracker
+{
+  public:
+    explicit NeighborTracker(double radius)
+        : m_r2(radius * radius),
+          m_invCell(1.0 / (std::max(radius, 1e-9) * (1.0 + 1e-9)))
+    {
+    }
+
+    /**
+     * Record the position of a node for the current frame. Nodes seen for
+     * the first time join the tracker.
+     */
+    void Move(uint32_t id, double x, double y)
+    {
+        if (id >= m_nodes.size())
+        {
+            m_nodes.resize(id + 1);
+        }
+        Node& node = m_nodes[id];
+        if (node.present && node.x == x && node.y == y)
+        {
+            return;
+        }
+        node.x = x;
+        node.y = y;
+        uint64_t cell = CellKey(x, y);
+        if (!node.present || cell != node.cell)
+        {
+            if (node.present)
+            {
+                Unlink(id);
+            }
+            else
+            {
+                m_present++;
+            }
+            node.cell = cell;
+            std::vector<uint32_t>& members = m_cells[cell];
+            node.slot = static_cast<uint32_t>(members.size());
+            members.push_back(id);
+            node.present = true;
+            m_rehashed++;
+        }
+        if (!node.dirty)
+        {
+            node.dirty = true;
+            m_moved.push_back(id);
+        }
+    }
+
+    /**
+     * Close the frame: refresh the neighbor sets of the nodes moved since
+     * the previous call and append the link changes to events.
+     */
+    void Commit(std::vector<LinkEvent>& events)
+    {
+        std::vector<uint32_t> fresh;
+        for (uint32_t id : m_moved)
+        {
+            Node& node = m_nodes[id];
+            node.dirty = false;
+            Scan(id, fresh);
+
+            // Both lists are sorted: walk them together.
+            std::vector<uint32_t>& old = node.neigh;
+            size_t i = 0;
+            size_t j = 0;
+            while (i < old.size() || j < fresh.size())
+            {
+                if (j == fresh.size() || (i < old.size() && old[i] < fresh[j]))
+                {
+                    Erase(m_nodes[old[i]].neigh, id);
+                    events.push_back({std::min(id, old[i]), std::max(id, old[i]), false});
+                    i++;
+                }
+                else if (i == old.size() || fresh[j] < old[i])
+                {
+                    Insert(m_nodes[fresh[j]].neigh, id);
+                    events.push_back({std::min(id, fresh[j]), std::max(id, fresh[j]), true});
+                    j++;
+                }
+                else
+                {
+                    i++;
+                    j++;
+                }
+            }
+            old.swap(fresh);
+        }
+        m_moved.clear();
+    }
+
+    /// Distinct node ids seen so far (ids need not be contiguous).
+    uint32_t GetN() const
+    {
+        return m_present;
+    }
+
+    const std::vector<uint32_t>& Neighbors(uint32_t id) const
+    {
+        return m_nodes[id].neigh;
+    }
+
+    /// Number of pending moved nodes (cleared by Commit()).
+    size_t PendingMoves() const
+    {
+        return m_moved.size();
+    }
+
+    /// Cell changes since construction.
+    uint64_t Rehashed() const
+    {
+        return m_rehashed;
+    }
+
+  private:
+    struct Node
+    {
+        double x = 0;
+        double y = 0;
+        uint64_t cell = 0;
+        uint32_t slot = 0;
+        bool present = false;
+        bool dirty = false;
+        std::vector<uint32_t> neigh; //!< sorted ids
+    };
+
+    uint64_t CellKey(double x, double y) const
+    {
+        return Key(static_cast<int32_t>(std::floor(x * m_invCell)),
+                   static_cast<int32_t>(std::floor(y * m_invCell)));
+    }
+
+    static uint64_t Key(int32_t cx, int32_t cy)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+               static_cast<uint32_t>(cy);
+    }
+
+    void Unlink(uint32_t id)
+    {
+        Node& node = m_nodes[id];
+        auto it = m_cells.find(node.cell);
+        std::vector<uint32_t>& members = it->second;
+        uint32_t last = members.back();
+        members[node.slot] = last;
+        m_nodes[last].slot = node.slot;
+        members.pop_back();
+        if (members.empty())
+        {
+            m_cells.erase(it);
+        }
+    }
+
+    void Scan(uint32_t id, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        const Node& node = m_nodes[id];
+        int32_t cx = static_cast<int32_t>(std::floor(node.x * m_invCell));
+        int32_t cy = static_cast<int32_t>(std::floor(node.y * m_invCell));
+        for (int32_t dy = -1; dy <= 1; dy++)
+        {
+            for (int32_t dx = -1; dx <= 1; dx++)
+            {
+                auto it = m_cells.find(Key(cx + dx, cy + dy));
+                if (it == m_cells.end())
+                {
+                    continue;
+                }
+                for (uint32_t other : it->second)
+                {
+                    const Node& o = m_nodes[other];
+                    double ey = o.y - node.y;
+                    double ex = o.x - node.x;
+                    if (other != id && ey * ey + ex * ex <= m_r2)
+                    {
+                        out.push_back(other);
+                    }
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    static void Insert(std::vector<uint32_t>& set, uint32_t id)
+    {
+        auto it = std::lower_bound(set.begin(), set.end(), id);
+        if (it == set.end() || *it != id)
+        {
+            set.insert(it, id);
+        }
+    }
+
+    static void Erase(std::vector<uint32_t>& set, uint32_t id)
+    {
+        auto it = std::lower_bound(set.begin(), set.end(), id);
+        if (it != set.end() && *it == id)
+        {
+            set.erase(it);
+        }
+    }
+
+    double m_r2;
+    double m_invCell;
+    std::vector<Node> m_nodes;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint32_t> m_moved;
+    uint32_t m_present = 0; //!< nodes with present set
+    uint64_t m_rehashed = 0;
+};
+
+#endif /* NEIGHBOR_TRACKER_H */
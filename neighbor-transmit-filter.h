@@ -0,0 +1,127 @@
+/*
+ * Spectrum transmit filter that only lets a signal through to receivers in
+ * range of the transmitter, for static topologies.
+ *
+ * The in-range lists are computed once from node positions with the
+ * spatial grid (see topology-graph.h). Filtered receivers are skipped
+ * before the channel evaluates propagation loss and schedules a reception,
+ * so a transmission costs O(degree) loss computations and events instead
+ * of O(N).
+ */
+
+#ifndef NEIGHBOR_TRANSMIT_FILTER_H
+#define NEIGHBOR_TRANSMIT_FILTER_H
+
+#include "spatial-grid.h"
+#include "topology-graph.h"
+
+#include "ns3/mobility-model.h"
+#include "ns3/net-device.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/spectrum-transmit-filter.h"
+
+#include <limits>
+#include <vector>
+
+namespace ns3
+{
+
+class NeighborListTransmitFilter : public SpectrumTransmitFilter
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::NeighborListTransmitFilter")
+                                .SetParent<SpectrumTransmitFilter>()
+                                .SetGroupName("Spectrum")
+                                .AddConstructor<NeighborListTransmitFilter>();
+        return tid;
+    }
+
+    /**
+     * Link every pair of nodes at most range apart (in the x/y plane, so
+     * the lists are a superset of what a 3D range model delivers). Nodes
+     * must not move afterwards; transmitters or receivers that were not
+     * part of nodes are never filtered.
+     */
+    void Build(const NodeContainer& nodes, double range, uint32_t threads = 0)
+    {
+        const uint32_t n = nodes.GetN();
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        m_index.clear();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            Ptr<Node> node = nodes.Get(i);
+            Vector p = node->GetObject<MobilityModel>()->GetPosition();
+            x[i] = p.x;
+            y[i] = p.y;
+            if (m_index.size() <= node->GetId())
+            {
+                m_index.resize(node->GetId() + 1, NONE);
+            }
+            m_index[node->GetId()] = i;
+        }
+
+        // Pad the radius so that rounding never drops a pair the
+        // propagation loss model would still deliver.
+        const double radius = range * (1.0 + 1e-9);
+        SpatialGrid grid;
+        grid.Build(x.data(), y.data(), n, radius);
+        m_graph = BuildUnitDiskGraph(grid, radius, threads);
+    }
+
+    const CsrGraph& GetGraph() const
+    {
+        return m_graph;
+    }
+
+    /// Receptions skipped since construction.
+    uint64_t GetFiltered() const
+    {
+        return m_filtered;
+    }
+
+  protected:
+    bool DoFilter(Ptr<const SpectrumSignalParameters> params,
+                  Ptr<const SpectrumPhy> receiverPhy) override
+    {
+        if (!params->txPhy)
+        {
+            return false;
+        }
+        uint32_t tx = Index(params->txPhy);
+        uint32_t rx = Index(receiverPhy);
+        if (tx == NONE || rx == NONE || m_graph.HasEdge(tx, rx))
+        {
+            return false;
+        }
+        m_filtered++;
+        return true;
+    }
+
+  private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    uint32_t Index(Ptr<const SpectrumPhy> phy) const
+    {
+        Ptr<NetDevice> device = phy->GetDevice();
+        if (!device || !device->GetNode())
+        {
+            return NONE;
+        }
+        uint32_t id = device->GetNode()->GetId();
+        return id < m_index.size() ? m_index[id] : NONE;
+    }
+
+    CsrGraph m_graph;
+    std::vector<uint32_t> m_index; //!< node id -> graph vertex
+    uint64_t m_filtered = 0;
+};
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_TRANSMIT_FILTER_H */
@@ -0,0 +1,318 @@
+/*
+ * Bounded-memory NetAnim writer.
+ *
+ * Writes the subset of the netanim-3.108 XML format the scenarios use:
+ * nodes, descriptions, colours, position updates and packets. Packets are
+ * taken from the IPv4 layer (one <p> per hop, sender to receiver) and
+ * sampled by uid, so every hop of a kept packet is drawn. Output is
+ * accumulated in a fixed-size chunk and written out whenever it fills,
+ * optionally through gzip; in-flight packets live in a fixed table. Memory
+ * therefore does not grow with the length of the run.
+ */
+
+#ifndef NETANIM_STREAM_H
+#define NETANIM_STREAM_H
+
+#include "ns3/callback.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class StreamingAnimation
+{
+  public:
+    ~StreamingAnimation()
+    {
+        Close();
+    }
+
+    /**
+     * Start writing filename (filename.gz through gzip if gzip is set):
+     * every node existing now is declared and watched. Output is written
+     * in chunks of chunkBytes.
+     */
+    bool Open(const std::string& filename, bool gzip = false, size_t chunkBytes = 1 << 20)
+    {
+        Close();
+        if (gzip)
+        {
+            m_filename = filename + ".gz";
+            m_file = popen(("gzip -c > '" + m_filename + "'").c_str(), "w");
+            m_piped = m_file != nullptr;
+        }
+        if (!m_file)
+        {
+            m_filename = filename;
+            m_file = std::fopen(filename.c_str(), "w");
+        }
+        if (!m_file)
+        {
+            return false;
+        }
+        m_chunkBytes = chunkBytes;
+        // As AnimationInterface: sub-millisecond hops stay apart after 10 s.
+        m_line.precision(10);
+        m_chunk.reserve(chunkBytes + 1024);
+        m_chunk = "<anim ver=\"netanim-3.108\" filetype=\"animation\" >\n";
+        m_last.assign(NodeList::GetNNodes(), Vector(0, 0, 0));
+        for (uint32_t i = 0; i < NodeList::GetNNodes(); i++)
+        {
+            Ptr<Node> node = NodeList::GetNode(i);
+            Vector p = Position(node);
+            m_last[i] = p;
+            m_line.str("");
+            m_line << "<node id=\"" << node->GetId() << "\" sysId=\"" << node->GetSystemId()
+                   << "\" locX=\"" << p.x << "\" locY=\"" << p.y << "\" />\n";
+            Append(m_line.str());
+            Watch(node);
+        }
+        m_poll = Simulator::Schedule(m_pollInterval, &StreamingAnimation::Poll, this);
+        return true;
+    }
+
+    /// Draw one packet in every sampleEvery (by uid); 1 = all of them.
+    void SetSampling(uint32_t sampleEvery)
+    {
+        m_sampleEvery = sampleEvery ? sampleEvery : 1;
+    }
+
+    /// Attach the packet's headers (Packet::Print) to drawn packets.
+    void EnablePacketMetadata(bool enable)
+    {
+        m_metadata = enable;
+        if (enable)
+        {
+            Packet::EnablePrinting();
+        }
+    }
+
+    void SetMobilityPollInterval(Time interval)
+    {
+        m_pollInterval = interval;
+    }
+
+    void UpdateNodeDescription(Ptr<Node> node, const std::string& description)
+    {
+        Update(node, "d") << " descr=\"" << Escape(description) << "\" />\n";
+        Append(m_line.str());
+    }
+
+    void UpdateNodeColor(Ptr<Node> node, uint8_t r, uint8_t g, uint8_t b)
+    {
+        Update(node, "c") << " r=\"" << uint32_t(r) << "\" g=\"" << uint32_t(g) << "\" b=\""
+                          << uint32_t(b) << "\" />\n";
+        Append(m_line.str());
+    }
+
+    /// Finish the document and close the file (waiting for gzip).
+    void Close()
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        Simulator::Cancel(m_poll);
+        Append("</anim>\n");
+        Flush();
+        if (m_piped)
+        {
+            pclose(m_file);
+        }
+        else
+        {
+            std::fclose(m_file);
+        }
+        m_file = nullptr;
+        m_piped = false;
+    }
+
+    const std::string& GetFilename() const
+    {
+        return m_filename;
+    }
+
+    /// Hops written as <p> elements.
+    uint64_t GetPackets() const
+    {
+        return m_packets;
+    }
+
+  private:
+    static constexpr uint32_t TABLE_BITS = 16;
+
+    struct InFlight
+    {
+        uint64_t uid = 0;
+        double sent = 0;
+        uint32_t node = 0;
+        bool valid = false;
+    };
+
+    static Vector Position(Ptr<Node> node)
+    {
+        Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+        return mobility ? mobility->GetPosition() : Vector(0, 0, 0);
+    }
+
+    static std::string Escape(const std::string& text)
+    {
+        std::string out;
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '&':
+                out += "&amp;";
+                break;
+            case '<':
+                out += "&lt;";
+                break;
+            case '>':
+                out += "&gt;";
+                break;
+            case '"':
+                out += "&quot;";
+                break;
+            default:
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    /// Start a <nu> element of kind p for node in m_line.
+    std::ostringstream& Update(Ptr<Node> node, const char* p)
+    {
+        m_line.str("");
+        m_line << "<nu p=\"" << p << "\" t=\"" << Simulator::Now().GetSeconds() << "\" id=\""
+               << node->GetId() << "\"";
+        return m_line;
+    }
+
+    void Watch(Ptr<Node> node)
+    {
+        Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+        if (!ipv4)
+        {
+            return;
+        }
+        ipv4->TraceConnectWithoutContext(
+            "Tx",
+            MakeBoundCallback(&StreamingAnimation::TraceTx, this, node->GetId()));
+        ipv4->TraceConnectWithoutContext(
+            "Rx",
+            MakeBoundCallback(&StreamingAnimation::TraceRx, this, node->GetId()));
+    }
+
+    bool Sampled(uint64_t uid) const
+    {
+        return m_sampleEvery == 1 || (uid * 0x9e3779b97f4a7c15ULL >> 32) % m_sampleEvery == 0;
+    }
+
+    static void TraceTx(StreamingAnimation* anim,
+                        uint32_t node,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        if (!anim->Sampled(packet->GetUid()))
+        {
+            return;
+        }
+        InFlight& slot = anim->m_table[packet->GetUid() & ((1 << TABLE_BITS) - 1)];
+        slot.uid = packet->GetUid();
+        slot.sent = Simulator::Now().GetSeconds();
+        slot.node = node;
+        slot.valid = true;
+    }
+
+    static void TraceRx(StreamingAnimation* anim,
+                        uint32_t node,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        const InFlight& slot = anim->m_table[packet->GetUid() & ((1 << TABLE_BITS) - 1)];
+        if (!slot.valid || slot.uid != packet->GetUid() || slot.node == node)
+        {
+            return;
+        }
+        const double now = Simulator::Now().GetSeconds();
+        std::ostringstream& line = anim->m_line;
+        line.str("");
+        line << "<p fId=\"" << slot.node << "\" fbTx=\"" << slot.sent << "\" lbTx=\"" << slot.sent
+             << "\" tId=\"" << node << "\" fbRx=\"" << now << "\" lbRx=\"" << now << "\"";
+        if (anim->m_metadata)
+        {
+            std::ostringstream meta;
+            packet->Print(meta);
+            line << " meta-info=\"" << Escape(meta.str()) << "\"";
+        }
+        line << " />\n";
+        anim->Append(line.str());
+        anim->m_packets++;
+    }
+
+    void Poll()
+    {
+        for (uint32_t i = 0; i < NodeList::GetNNodes() && i < m_last.size(); i++)
+        {
+            Ptr<Node> node = NodeList::GetNode(i);
+            Vector p = Position(node);
+            if (p.x == m_last[i].x && p.y == m_last[i].y)
+            {
+                continue;
+            }
+            m_last[i] = p;
+            Update(node, "p") << " x=\"" << p.x << "\" y=\"" << p.y << "\" />\n";
+            Append(m_line.str());
+        }
+        m_poll = Simulator::Schedule(m_pollInterval, &StreamingAnimation::Poll, this);
+    }
+
+    void Append(const std::string& text)
+    {
+        m_chunk += text;
+        if (m_chunk.size() >= m_chunkBytes)
+        {
+            Flush();
+        }
+    }
+
+    void Flush()
+    {
+        std::fwrite(m_chunk.data(), 1, m_chunk.size(), m_file);
+        m_chunk.clear();
+    }
+
+    std::FILE* m_file = nullptr;
+    bool m_piped = false;
+    std::string m_filename;
+    std::string m_chunk;
+    size_t m_chunkBytes = 1 << 20;
+    std::ostringstream m_line;
+    std::vector<InFlight> m_table = std::vector<InFlight>(size_t(1) << TABLE_BITS);
+    std::vector<Vector> m_last; //!< last written position, by node id
+    uint32_t m_sampleEvery = 1;
+    bool m_metadata = false;
+    Time m_pollInterval = Seconds(0.25);
+    EventId m_poll;
+    uint64_t m_packets = 0;
+};
+
+} // namespace ns3
+
+#endif /* NETANIM_STREAM_H */
@@ -1,75 +1,424 @@
 #include <iostream>
-#include <cmath>
-#include <cstring>
+#include <algorithm>
 #include <fstream>
-#include <stdio.h>
-#include <stdlib.h>
-#include <cstring>  // strtok, memcpy, memset
-#include <cstdlib>  // atof
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance-kernel.h"
+#include "neighbor-engine.h"
+#include "neighbor-tracker.h"
+#include "spatial-grid.h"
+#include "topology-graph.h"
+#include "topology-loader.h"
 
 using namespace std;
 
-int main ()
+// Parse "10,25,50" into radii; false on an empty or malformed list.
+static bool ParseRadii (const std::string &list, std::vector<double> &radii)
 {
-  std::string line;
-  ifstream file("manet100.csv");
-  
-  int i = 0, j = 0;
-  double vec[3] = {0};
-  double vecfull[100][2] = {0};
-  double neigh[100]= {0};
-  int rmin = 25;
-  double tmp = 0;
-  double sum = 0;
-  
-  if(file.is_open())
+  radii.clear();
+  const char *p = list.data();
+  const char *end = p + list.size();
+  while (p < end)
+  {
+	double r;
+	if (!CsvParseField(p, end, r) || r < 0)
+	{
+		return false;
+	}
+	radii.push_back(r);
+  }
+  return !radii.empty();
+}
+
+// Parse a whole unsigned decimal; false on an empty, partial or out of
+// range value.
+template <typename T>
+static bool ParseCount (const std::string &text, T &value)
+{
+  const char *end = text.data() + text.size();
+  auto res = std::from_chars(text.data(), end, value);
+  return !text.empty() && res.ec == std::errc() && res.ptr == end;
+}
+
+// Uniform random topology of n nodes, sized so that a node has about
+// `degree` neighbors within r.
+static void Synthetic (uint32_t n, double r, double degree, Topology &topo)
+{
+  double side = std::sqrt(n * M_PI * r * r / degree);
+  std::mt19937_64 rng(12345);
+  std::uniform_real_distribution<double> u(0, side);
+  topo.Clear();
+  topo.Reserve(n);
+  for (uint32_t i = 0; i < n; i++)
+  {
+	topo.id.push_back(i);
+	topo.x.push_back(u(rng));
+	topo.y.push_back(u(rng));
+  }
+}
+
+// Time the grid build and the parallel count at 1, 2, 4, 8 and 16 threads.
+static void Benchmark (const Topology &topo, const std::vector<double> &radii)
+{
+  using Clock = std::chrono::steady_clock;
+  std::vector<uint32_t> counts;
+  double base = 0;
+  std::cout << "nodes " << topo.Size() << ", radii " << radii.size()
+            << ", hardware threads " << std::thread::hardware_concurrency() << "\n";
+  std::cout << "threads\tbuild(ms)\tcount(ms)\tspeedup\n";
+  for (uint32_t threads : {1u, 2u, 4u, 8u, 16u})
+  {
+	auto t0 = Clock::now();
+	SpatialGrid grid;
+	grid.Build(topo.x.data(), topo.y.data(), topo.Size(), radii.back());
+	auto t1 = Clock::now();
+	CountNeighbors(grid, radii.data(), radii.size(), threads, counts);
+	auto t2 = Clock::now();
+	double build = std::chrono::duration<double, std::milli>(t1 - t0).count();
+	double count = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	if (threads == 1)
+	{
+		base = count;
+	}
+	std::cout << threads << "\t" << build << "\t" << count << "\t" << base / count << "\n";
+  }
+}
+
+// Screen the topology at each radius; returns false if any is partitioned.
+static bool Connectivity (const Topology &topo, const std::vector<double> &radii, uint32_t threads)
+{
+  using Clock = std::chrono::steady_clock;
+  bool connected = true;
+  for (double r : radii)
   {
-	while(getline(file,line))
+	auto t0 = Clock::now();
+	SpatialGrid grid;
+	grid.Build(topo.x.data(), topo.y.data(), topo.Size(), r);
+	CsrGraph g = BuildUnitDiskGraph(grid, r, threads);
+	ConnectivityReport rep = AnalyzeConnectivity(g);
+	double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+	std::cout << "Range " << r << "m: " << rep.nodes << " nodes, " << rep.links << " links\n";
+	std::cout << "  Components: " << rep.components << " (largest " << rep.largest
+	          << ", isolated " << rep.isolated << ")\n";
+	std::cout << "  Hop diameter (approx.): " << rep.hopDiameter << "\n";
+	std::cout << "  Degree histogram:";
+	for (size_t d = 0; d < rep.degreeHist.size(); d++)
 	{
-		char seps[] = ",";
-		char *token;
-		token = strtok(&line[0], seps);		
-		while(token != NULL)
+		if (rep.degreeHist[d])
 		{
-			vec[i] = atof(token);
-			i++;
-			token = strtok (NULL, ",");
-			if(i == 3)
-			{
-				vecfull[j][0] = vec[1];
-				vecfull[j][1] = vec[2];
-				j++;
-				i = 0;
-			}
-        }
+			std::cout << " " << d << ":" << rep.degreeHist[d];
+		}
+	}
+	std::cout << "\n  Connected: " << (rep.Connected() ? "yes" : "no")
+	          << " (" << ms << " ms)\n\n";
+	connected = connected && rep.Connected();
+  }
+  return connected;
+}
 
-	  }
-	  file.close();
+// Replay a "time,id,x,y" trace (rows grouped by time) through the
+// incremental tracker: one summary line per frame, link changes to `links`.
+static bool Trace (const std::string &path, double r, const std::string &links)
+{
+  MappedFile file;
+  if (!file.Open(path))
+  {
+	std::cout << "Error in trace file: cannot open " << path << "\n";
+	return false;
+  }
+  std::ofstream out;
+  if (!links.empty())
+  {
+	out.open(links);
+	out << "time,event,a,b\n";
+  }
+
+  NeighborTracker tracker(r);
+  std::vector<LinkEvent> events;
+  uint64_t frames = 0, moves = 0, ups = 0, downs = 0, current = 0;
+  double first = 0, now = 0;
+  bool open = false;
+  auto commit = [&]() {
+	size_t moved = tracker.PendingMoves();
+	events.clear();
+	tracker.Commit(events);
+	uint64_t up = 0;
+	for (const LinkEvent &e : events)
+	{
+		up += e.up;
+		if (out.is_open())
+		{
+			out << now << "," << (e.up ? "up" : "down") << "," << e.a << "," << e.b << "\n";
+		}
 	}
-	else
+	uint64_t down = events.size() - up;
+	current += up;
+	current -= down;
+	std::cout << now << "\t" << moved << "\t" << up << "\t" << down << "\t" << current << "\n";
+	if (frames > 0)
 	{
-	  std::cout<<"Error in csv file"<< '\n';
+		ups += up;
+		downs += down;
 	}
-	
-	for(i = 0; i < 100; i++)
+	moves += moved;
+	frames++;
+  };
+
+  std::cout << "time\tmoved\tup\tdown\tlinks\n";
+  const char *p = file.Data();
+  const char *end = p + file.Size();
+  uint64_t line = 0;
+  while (p < end)
+  {
+	const char *next;
+	const char *eol = CsvLineEnd(p, end, next);
+	line++;
+	double t, x, y;
+	uint32_t id;
+	const char *f = p;
+	if (f != eol && CsvParseField(f, eol, t) && CsvParseField(f, eol, id) &&
+	    CsvParseField(f, eol, x) && CsvParseField(f, eol, y) && f == eol)
 	{
-		for(j = 0; j < 100; j++)
+		if (open && t != now)
 		{
-			if(i == j)
-			{}
-			else
+			commit();
+		}
+		if (!open)
+		{
+			first = t;
+		}
+		open = true;
+		now = t;
+		tracker.Move(id, x, y);
+	}
+	else if (f != eol && line > 1)
+	{
+		std::cout << "Error in trace file: malformed row at line " << line << "\n";
+		return false;
+	}
+	p = next;
+  }
+  if (open)
+  {
+	commit();
+  }
+
+  // The first frame only builds the initial neighbor sets.
+  double span = now - first;
+  std::cout << "\nFrames: " << frames << ", node moves: " << moves
+            << ", cell changes: " << tracker.Rehashed() << "\n";
+  std::cout << "Link changes after the first frame: " << ups << " up, " << downs << " down";
+  if (span > 0)
+  {
+	std::cout << " (" << (ups + downs) / span << " per second)";
+  }
+  std::cout << "\nMean number of neighbors at the end: "
+            << (tracker.GetN() ? 2.0 * current / tracker.GetN() : 0) << "\n\n";
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  // --mode=grid (default) uses the spatial index, --mode=brute keeps the
+  // all-pairs loop as a reference. --file selects the topology and
+  // --kernel pins the distance kernel (auto, scalar, avx2, avx512).
+  // --radii=10,25,50 sweeps several ranges in one pass over the grid.
+  // --threads=N sets the workers (0 = all cores); --bench times 1 to 16
+  // threads on a synthetic topology of --nodes nodes (default 1M).
+  // --mode=connectivity reports components, degrees and hop diameter and
+  // exits with status 2 when a radius leaves the network partitioned.
+  // --size=N keeps the first N nodes, as manet-28 --size does.
+  // --trace=file replays a time,id,x,y mobility trace incrementally and
+  // --links=file writes the link up/down events it produces.
+  std::string mode = "grid";
+  std::string trace, links;
+  size_t size = 0;
+  uint32_t threads = 0;
+  uint32_t nodes = 1000000;
+  bool bench = false;
+  std::string kernel = "auto";
+  std::string topology = "manet100.csv";
+  std::vector<double> radii = {25};
+  for (int a = 1; a < argc; a++)
+  {
+	std::string arg = argv[a];
+	if (arg.rfind("--mode=", 0) == 0)
+	{
+		mode = arg.substr(7);
+	}
+	else if (arg.rfind("--file=", 0) == 0)
+	{
+		topology = arg.substr(7);
+	}
+	else if (arg.rfind("--kernel=", 0) == 0)
+	{
+		kernel = arg.substr(9);
+	}
+	else if (arg.rfind("--threads=", 0) == 0)
+	{
+		if (!ParseCount(arg.substr(10), threads))
+		{
+			std::cout << "Bad value " << arg << "\n";
+			return 1;
+		}
+	}
+	else if (arg.rfind("--nodes=", 0) == 0)
+	{
+		if (!ParseCount(arg.substr(8), nodes))
+		{
+			std::cout << "Bad value " << arg << "\n";
+			return 1;
+		}
+	}
+	else if (arg.rfind("--size=", 0) == 0)
+	{
+		if (!ParseCount(arg.substr(7), size))
+		{
+			std::cout << "Bad value " << arg << "\n";
+			return 1;
+		}
+	}
+	else if (arg.rfind("--trace=", 0) == 0)
+	{
+		trace = arg.substr(8);
+	}
+	else if (arg.rfind("--links=", 0) == 0)
+	{
+		links = arg.substr(8);
+	}
+	else if (arg == "--bench")
+	{
+		bench = true;
+	}
+	else if (arg.rfind("--radii=", 0) == 0 || arg.rfind("--rmin=", 0) == 0)
+	{
+		if (!ParseRadii(arg.substr(arg.find('=') + 1), radii))
+		{
+			std::cout << "Bad radius list " << arg << "\n";
+			return 1;
+		}
+	}
+  }
+  if (mode != "grid" && mode != "brute" && mode != "connectivity")
+  {
+	std::cout << "Unknown mode " << mode << " (grid, brute or connectivity)\n";
+	return 1;
+  }
+  if (!SelectDistanceKernel(kernel))
+  {
+	std::cout << "Kernel " << kernel << " is not available on this CPU\n";
+	return 1;
+  }
+  std::sort(radii.begin(), radii.end());
+  radii.erase(std::unique(radii.begin(), radii.end()), radii.end());
+
+  Topology topo;
+  std::string error;
+  double tmp = 0;
+
+  if (!trace.empty())
+  {
+	return Trace(trace, radii.back(), links) ? 0 : 1;
+  }
+  if (bench)
+  {
+	Synthetic(nodes, radii.back(), 20, topo);
+	Benchmark(topo, radii);
+	return 0;
+  }
+  if (!LoadTopology(topology, topo, &error))
+  {
+	std::cout << "Error in csv file: " << error << '\n';
+	return 1;
+  }
+  if (size > 0 && size < topo.Size())
+  {
+	topo.id.resize(size);
+	topo.x.resize(size);
+	topo.y.resize(size);
+  }
+  if (mode == "connectivity")
+  {
+	return Connectivity(topo, radii, threads) ? 0 : 2;
+  }
+
+  const size_t n = topo.Size();
+  const size_t nr = radii.size();
+  const double *xs = topo.x.data();
+  const double *ys = topo.y.data();
+  // neigh[i * nr + k]: neighbors of node i within radii[k]
+  std::vector<uint32_t> neigh(n * nr, 0);
+
+  std::vector<NeighborTotals> totals(nr);
+  if (mode == "grid")
+  {
+	SpatialGrid grid;
+	grid.Build(xs, ys, n, radii.back());
+	totals = CountNeighbors(grid, radii.data(), nr, threads, neigh);
+  }
+  else
+  {
+	for(size_t k = 0; k < nr; k++)
+	{
+		double rmin = radii[k];
+		for(size_t i = 0; i < n; i++)
+		{
+			for(size_t j = 0; j < n; j++)
 			{
-				tmp = ((vecfull[j][1]-vecfull[i][1])*(vecfull[j][1]-vecfull[i][1])) + ((vecfull[j][0]-vecfull[i][0])*(vecfull[j][0]-vecfull[i][0]));
-				if(tmp <= (rmin*rmin))
+				if(i == j)
+				{}
+				else
 				{
-					neigh[i]++;
+					tmp = ((ys[j]-ys[i])*(ys[j]-ys[i])) + ((xs[j]-xs[i])*(xs[j]-xs[i]));
+					if(tmp <= (rmin*rmin))
+					{
+						neigh[i * nr + k]++;
+					}
 				}
 			}
 		}
-		std::cout << neigh[i] << "\n";
-		sum += neigh[i];
 	}
-	sum = sum / 100;
-	cout << "\nMean number of neighbors for rmin of " << rmin << "m are " << (sum / 100) << ".\n\n";
-	return 0;
+	for(size_t i = 0; i < n; i++)
+	{
+		for(size_t k = 0; k < nr; k++)
+		{
+			totals[k].Add(neigh[i * nr + k]);
+		}
+	}
+  }
+
+  // One line per node, one column per radius.
+  for(size_t i = 0; i < n; i++)
+  {
+	for(size_t k = 0; k < nr; k++)
+	{
+		std::cout << (k ? " " : "") << neigh[i * nr + k];
+	}
+	std::cout << "\n";
+  }
+
+  std::cout << "\n";
+  for(size_t k = 0; k < nr; k++)
+  {
+	double sum = totals[k].sum;
+	if (n > 0)
+	{
+		sum = sum / n;
+	}
+	cout << "Mean number of neighbors for rmin of " << radii[k] << "m are " << sum << ".";
+	if (nr > 1)
+	{
+		cout << " (min " << (n ? totals[k].min : 0) << ", max " << totals[k].max
+		     << ", isolated " << totals[k].isolated << ")";
+	}
+	cout << "\n";
+  }
+  cout << "\n";
+  return 0;
 }
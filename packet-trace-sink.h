@@ -0,0 +1,196 @@
+/*
+ * ns-3 side of the binary packet trace (packet-trace.h).
+ *
+ * Records what every watched node's IPv4 layer hands to or receives from
+ * its devices, plus IPv4 drops, with the packet's 5-tuple hash. The
+ * 5-tuples seen are listed in "<file>.flows" (hash,source,destination,
+ * protocol,source_port,destination_port) so the hashes can be named.
+ */
+
+#ifndef PACKET_TRACE_SINK_H
+#define PACKET_TRACE_SINK_H
+
+#include "packet-trace.h"
+
+#include "ns3/callback.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/net-device.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace ns3
+{
+
+class PacketTraceSink
+{
+  public:
+    ~PacketTraceSink()
+    {
+        Close();
+    }
+
+    bool Open(const std::string& filename)
+    {
+        m_filename = filename;
+        m_flows.clear();
+        return m_writer.Open(filename);
+    }
+
+    /// Trace the IPv4 layer of every node of nodes that has one.
+    void Watch(const NodeContainer& nodes)
+    {
+        for (uint32_t i = 0; i < nodes.GetN(); i++)
+        {
+            Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+            if (!ipv4)
+            {
+                continue;
+            }
+            const uint32_t node = nodes.Get(i)->GetId();
+            ipv4->TraceConnectWithoutContext(
+                "Tx",
+                MakeBoundCallback(&PacketTraceSink::TraceIp,
+                                  this,
+                                  node,
+                                  PacketTraceRecord::ENQUEUE));
+            ipv4->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&PacketTraceSink::TraceIp,
+                                  this,
+                                  node,
+                                  PacketTraceRecord::RECEIVE));
+            ipv4->TraceConnectWithoutContext(
+                "Drop",
+                MakeBoundCallback(&PacketTraceSink::TraceDrop, this, node));
+        }
+    }
+
+    /// Write the remaining records and the flow table.
+    void Close()
+    {
+        if (!m_writer.IsOpen())
+        {
+            return;
+        }
+        m_writer.Close();
+        std::ofstream out(m_filename + ".flows");
+        out << "hash,source,destination,protocol,source_port,destination_port\n";
+        for (const auto& [hash, flow] : m_flows)
+        {
+            out << hash << "," << flow.source << "," << flow.destination << ","
+                << uint32_t(flow.protocol) << "," << flow.sourcePort << ","
+                << flow.destinationPort << "\n";
+        }
+    }
+
+    uint64_t GetCount() const
+    {
+        return m_writer.GetCount();
+    }
+
+  private:
+    struct FiveTuple
+    {
+        Ipv4Address source;
+        Ipv4Address destination;
+        uint8_t protocol;
+        uint16_t sourcePort;
+        uint16_t destinationPort;
+    };
+
+    static void TraceIp(PacketTraceSink* sink,
+                        uint32_t node,
+                        uint8_t event,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        Ipv4Header ip;
+        packet->PeekHeader(ip);
+        sink->Record(node, Device(ipv4, interface), event, packet, ip, ip.GetSerializedSize());
+    }
+
+    /// Drops carry the IPv4 header apart from the packet.
+    static void TraceDrop(PacketTraceSink* sink,
+                          uint32_t node,
+                          const Ipv4Header& ip,
+                          Ptr<const Packet> packet,
+                          Ipv4L3Protocol::DropReason reason,
+                          Ptr<Ipv4> ipv4,
+                          uint32_t interface)
+    {
+        sink->Record(node, Device(ipv4, interface), PacketTraceRecord::DROP, packet, ip, 0);
+    }
+
+    static uint16_t Device(Ptr<Ipv4> ipv4, uint32_t interface)
+    {
+        Ptr<NetDevice> device = interface < ipv4->GetNInterfaces()
+                                    ? ipv4->GetNetDevice(interface)
+                                    : Ptr<NetDevice>();
+        return device ? static_cast<uint16_t>(device->GetIfIndex()) : 0xffff;
+    }
+
+    /// The transport header starts offset bytes into packet.
+    void Record(uint32_t node,
+                uint16_t device,
+                uint8_t event,
+                Ptr<const Packet> packet,
+                const Ipv4Header& ip,
+                uint32_t offset)
+    {
+        PacketTraceRecord r;
+        r.time = Simulator::Now().GetNanoSeconds();
+        r.uid = packet->GetUid();
+        r.node = node;
+        r.size = packet->GetSize() + (offset ? 0 : ip.GetSerializedSize());
+        r.device = device;
+        r.event = event;
+        r.protocol = ip.GetProtocol();
+        r.flow = Classify(packet, ip, offset);
+        m_writer.Append(r);
+    }
+
+    uint32_t Classify(Ptr<const Packet> packet, const Ipv4Header& ip, uint32_t offset)
+    {
+        FiveTuple t{ip.GetSource(), ip.GetDestination(), ip.GetProtocol(), 0, 0};
+        // Later fragments carry no transport header: keep ports at 0. Both
+        // UDP and TCP start with the two ports, read from a copy of the
+        // leading bytes rather than a deserialized header.
+        const uint32_t header = t.protocol == UDP ? 8 : 20;
+        uint8_t bytes[64];
+        if (ip.GetFragmentOffset() == 0 && (t.protocol == UDP || t.protocol == TCP) &&
+            offset + 4 <= sizeof(bytes) && packet->GetSize() >= offset + header)
+        {
+            packet->CopyData(bytes, offset + 4);
+            t.sourcePort = static_cast<uint16_t>(bytes[offset] << 8 | bytes[offset + 1]);
+            t.destinationPort = static_cast<uint16_t>(bytes[offset + 2] << 8 | bytes[offset + 3]);
+        }
+        const uint32_t hash = PacketTraceFlowHash(t.source.Get(),
+                                                  t.destination.Get(),
+                                                  t.protocol,
+                                                  t.sourcePort,
+                                                  t.destinationPort);
+        if (m_flows.find(hash) == m_flows.end())
+        {
+            m_flows.emplace(hash, t);
+        }
+        return hash;
+    }
+
+    static constexpr uint8_t TCP = 6;
+    static constexpr uint8_t UDP = 17;
+
+    PacketTraceWriter m_writer;
+    std::string m_filename;
+    std::unordered_map<uint32_t, FiveTuple> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* PACKET_TRACE_SINK_H */
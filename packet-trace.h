@@ -0,0 +1,279 @@
+/*
+ * Compact binary packet trace: a 32-byte header followed by fixed 32-byte
+ * records (time, node, device, event, packet uid, size, 5-tuple hash).
+ *
+ * PacketTraceWriter fills one buffer while a background thread writes the
+ * other, so the simulation only pays for a struct copy per event.
+ * PacketTraceReader maps the file and exposes the records as an array.
+ * Neither depends on ns-3; see packet-trace-sink.h for the trace sources.
+ */
+
+#ifndef PACKET_TRACE_H
+#define PACKET_TRACE_H
+
+#include "mapped-file.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PacketTraceHeader
+{
+    static constexpr char MAGIC[8] = {'M', 'A', 'N', 'E', 'T', 'P', 'K', 'T'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count; //!< 0 if the writer was not closed: use the file size
+    uint64_t reserved;
+};
+
+struct PacketTraceRecord
+{
+    /// Event codes, the letters of the ns-3 ASCII traces.
+    static constexpr uint8_t ENQUEUE = '+'; //!< handed to the device
+    static constexpr uint8_t RECEIVE = 'r'; //!< received from the device
+    static constexpr uint8_t DROP = 'd';
+
+    int64_t time; //!< ns
+    uint64_t uid;
+    uint32_t node;
+    uint32_t size; //!< bytes, network layer
+    uint32_t flow; //!< PacketTraceFlowHash of the 5-tuple, 0 if unknown
+    uint16_t device;
+    uint8_t event;
+    uint8_t protocol; //!< IP protocol number, 0 if unknown
+};
+
+static_assert(sizeof(PacketTraceHeader) == 32, "packet trace header must stay 32 bytes");
+static_assert(sizeof(PacketTraceRecord) == 32, "packet trace records must stay 32 bytes");
+
+/// 32-bit hash of an IPv4 5-tuple; never 0.
+inline uint32_t
+PacketTraceFlowHash(uint32_t source,
+                    uint32_t destination,
+                    uint8_t protocol,
+                    uint16_t sourcePort,
+                    uint16_t destinationPort)
+{
+    uint64_t h = (static_cast<uint64_t>(source) << 32) | destination;
+    h ^= (static_cast<uint64_t>(protocol) << 32 | static_cast<uint64_t>(sourcePort) << 16 |
+          destinationPort) *
+         0x9e3779b97f4a7c15ULL;
+    // splitmix64 finalizer
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    const uint32_t folded = static_cast<uint32_t>(h ^ (h >> 32));
+    return folded ? folded : 1;
+}
+
+class PacketTraceWriter
+{
+  public:
+    PacketTraceWriter() = default;
+    PacketTraceWriter(const PacketTraceWriter&) = delete;
+    PacketTraceWriter& operator=(const PacketTraceWriter&) = delete;
+
+    ~PacketTraceWriter()
+    {
+        Close();
+    }
+
+    /// Create path; capacity records are buffered per write.
+    bool Open(const std::string& path, size_t capacity = 1 << 16)
+    {
+        Close();
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        PacketTraceHeader header = MakeHeader(0);
+        std::fwrite(&header, sizeof(header), 1, m_file);
+        m_capacity = capacity ? capacity : 1;
+        m_front.reserve(m_capacity);
+        m_back.reserve(m_capacity);
+        m_written = 0;
+        m_pending = false;
+        m_stop = false;
+        m_thread = std::thread(&PacketTraceWriter::Loop, this);
+        return true;
+    }
+
+    bool IsOpen() const
+    {
+        return m_file != nullptr;
+    }
+
+    void Append(const PacketTraceRecord& record)
+    {
+        m_front.push_back(record);
+        if (m_front.size() == m_capacity)
+        {
+            Hand();
+        }
+    }
+
+    /// Write everything out, record the count in the header and close.
+    void Close()
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        if (!m_front.empty())
+        {
+            Hand();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+
+        PacketTraceHeader header = MakeHeader(m_written);
+        std::fseek(m_file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, m_file);
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_front.clear();
+        m_back.clear();
+    }
+
+    uint64_t GetCount() const
+    {
+        return m_written + m_front.size();
+    }
+
+  private:
+    static PacketTraceHeader MakeHeader(uint64_t count)
+    {
+        PacketTraceHeader header;
+        std::memcpy(header.magic, PacketTraceHeader::MAGIC, 8);
+        header.version = PacketTraceHeader::VERSION;
+        header.recordSize = sizeof(PacketTraceRecord);
+        header.count = count;
+        header.reserved = 0;
+        return header;
+    }
+
+    /// Swap the full front buffer with the back one once the thread is done with it.
+    void Hand()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_pending; });
+        m_front.swap(m_back);
+        m_pending = true;
+        lock.unlock();
+        m_cv.notify_all();
+        m_front.clear();
+    }
+
+    void Loop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_cv.wait(lock, [this] { return m_pending || m_stop; });
+            if (!m_pending)
+            {
+                return;
+            }
+            lock.unlock();
+            std::fwrite(m_back.data(), sizeof(PacketTraceRecord), m_back.size(), m_file);
+            lock.lock();
+            m_written += m_back.size();
+            m_back.clear();
+            m_pending = false;
+            m_cv.notify_all();
+        }
+    }
+
+    std::FILE* m_file = nullptr;
+    size_t m_capacity = 0;
+    std::vector<PacketTraceRecord> m_front; //!< filled by Append
+    std::vector<PacketTraceRecord> m_back;  //!< being written by m_thread
+    uint64_t m_written = 0;
+    bool m_pending = false; //!< m_back holds records to write
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+};
+
+class PacketTraceReader
+{
+  public:
+    bool Open(const std::string& path, std::string* error = nullptr)
+    {
+        m_records = nullptr;
+        m_count = 0;
+        if (!m_file.Open(path))
+        {
+            return Fail(error, "cannot open " + path);
+        }
+        const char* data = m_file.Data();
+        const size_t size = m_file.Size();
+        PacketTraceHeader header;
+        if (size < sizeof(header) || std::memcmp(data, PacketTraceHeader::MAGIC, 8) != 0)
+        {
+            return Fail(error, "not a binary packet trace");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version != PacketTraceHeader::VERSION ||
+            header.recordSize != sizeof(PacketTraceRecord))
+        {
+            return Fail(error, "unsupported packet trace version");
+        }
+        // A trace whose writer did not close has a zero count but whole
+        // records up to the last completed write.
+        const uint64_t available = (size - sizeof(header)) / sizeof(PacketTraceRecord);
+        m_count = header.count && header.count <= available ? header.count : available;
+        m_records = reinterpret_cast<const PacketTraceRecord*>(data + sizeof(header));
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return m_count;
+    }
+
+    const PacketTraceRecord& operator[](size_t i) const
+    {
+        return m_records[i];
+    }
+
+    const PacketTraceRecord* begin() const
+    {
+        return m_records;
+    }
+
+    const PacketTraceRecord* end() const
+    {
+        return m_records + m_count;
+    }
+
+  private:
+    static bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    MappedFile m_file;
+    const PacketTraceRecord* m_records = nullptr;
+    size_t m_count = 0;
+};
+
+#endif /* PACKET_TRACE_H */
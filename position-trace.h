@@ -0,0 +1,74 @@
+/*
+ * Periodic "time,id,x,y" position trace for mobile scenarios, in the format
+ * number_of_neighbors --trace replays. A node is written again only when
+ * it has moved since the previous sample.
+ */
+
+#ifndef POSITION_TRACE_H
+#define POSITION_TRACE_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class PositionTraceWriter
+{
+  public:
+    /**
+     * Sample the positions of nodes every interval, starting now, into
+     * filename.
+     */
+    void Start(const NodeContainer& nodes, Time interval, const std::string& filename)
+    {
+        m_nodes = nodes;
+        m_interval = interval;
+        m_last.assign(nodes.GetN(), Vector(0, 0, 0));
+        m_written.assign(nodes.GetN(), false);
+        m_out.open(filename);
+        m_out.precision(10);
+        m_out << "time,id,x,y\n";
+        Simulator::ScheduleNow(&PositionTraceWriter::Sample, this);
+    }
+
+  private:
+    void Sample()
+    {
+        double now = Simulator::Now().GetSeconds();
+        for (uint32_t i = 0; i < m_nodes.GetN(); i++)
+        {
+            Ptr<Node> node = m_nodes.Get(i);
+            Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+            if (!mobility)
+            {
+                continue;
+            }
+            Vector p = mobility->GetPosition();
+            if (m_written[i] && p.x == m_last[i].x && p.y == m_last[i].y)
+            {
+                continue;
+            }
+            m_out << now << "," << node->GetId() << "," << p.x << "," << p.y << "\n";
+            m_last[i] = p;
+            m_written[i] = true;
+        }
+        Simulator::Schedule(m_interval, &PositionTraceWriter::Sample, this);
+    }
+
+    NodeContainer m_nodes;
+    Time m_interval;
+    std::vector<Vector> m_last;
+    std::vector<bool> m_written;
+    std::ofstream m_out;
+};
+
+} // namespace ns3
+
+#endif /* POSITION_TRACE_H */
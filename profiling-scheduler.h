@@ -0,0 +1,351 @@
+/*
+ * Event-dispatch profiler.
+ *
+ * ProfilingScheduler wraps the simulator's scheduler (a MapScheduler by
+ * default). The default simulator invokes each event between two calls to
+ * RemoveNext(), so the wall-clock time from one RemoveNext() to the next
+ * is what the previous event cost. That time and a count are charged to
+ * the event's implementation type (MakeEvent's class, which carries the
+ * target's class and signature) and to its context, the node it runs on.
+ * Time spent inside the wrapped scheduler, including the inserts an event
+ * makes, is charged to a "Scheduler" entry instead.
+ *
+ * Counters live in a per-thread table that only its thread writes; the
+ * report merges the tables of every thread. EventProfile::Report() prints
+ * a ranked table and EventProfile::WriteFolded() writes a folded-stack
+ * file for flamegraph.pl (scenario;type;node value-in-microseconds).
+ */
+
+#ifndef PROFILING_SCHEDULER_H
+#define PROFILING_SCHEDULER_H
+
+#include "ns3/event-impl.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class EventProfile
+{
+  public:
+    struct Cost
+    {
+        uint64_t count = 0;
+        uint64_t ns = 0;
+    };
+
+    /// (type, context) of an event; a null type is the scheduler itself.
+    struct Key
+    {
+        const std::type_info* type;
+        uint32_t context;
+
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && context == other.context;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<const void*>()(key.type) * 31 + key.context;
+        }
+    };
+
+    using Table = std::unordered_map<Key, Cost, KeyHash>;
+
+    /// The calling thread's table, registered on first use.
+    static Table& Local()
+    {
+        thread_local Table* table = Register();
+        return *table;
+    }
+
+    static void Add(const std::type_info* type, uint32_t context, uint64_t ns)
+    {
+        Cost& cost = Local()[Key{type, context}];
+        cost.count++;
+        cost.ns += ns;
+    }
+
+    /// All threads' counters, merged.
+    static Table Merge()
+    {
+        std::lock_guard<std::mutex> lock(Registry().mutex);
+        Table merged;
+        for (const auto& table : Registry().tables)
+        {
+            for (const auto& [key, cost] : *table)
+            {
+                Cost& sum = merged[key];
+                sum.count += cost.count;
+                sum.ns += cost.ns;
+            }
+        }
+        return merged;
+    }
+
+    /// Readable name of an event type: demangled, without "ns3::".
+    static std::string Name(const std::type_info* type)
+    {
+        if (!type)
+        {
+            return "Scheduler";
+        }
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+        std::string name = status == 0 ? demangled : type->name();
+        std::free(demangled);
+        for (size_t at; (at = name.find("ns3::")) != std::string::npos;)
+        {
+            name.erase(at, 5);
+        }
+        std::replace(name.begin(), name.end(), ';', ':');
+        return name;
+    }
+
+    /// Ranked tables by event type and by node, top rows of each.
+    static void Report(std::ostream& os, size_t rows = 20)
+    {
+        std::map<const std::type_info*, Cost> byType;
+        std::map<uint32_t, Cost> byNode;
+        Cost total;
+        uint64_t dispatches = 0;
+        for (const auto& [key, cost] : Merge())
+        {
+            Accumulate(byType[key.type], cost);
+            if (key.type)
+            {
+                Accumulate(byNode[key.context], cost);
+                dispatches += cost.count;
+            }
+            Accumulate(total, cost);
+        }
+
+        os << "Event profile: " << dispatches << " events, " << total.ns * 1e-9 << " s\n";
+        os << "  rank     share       ms      events    ns/event  type\n";
+        Print(os, Ranked(byType), total, rows, [](const std::type_info* type) {
+            return Name(type);
+        });
+        os << "  rank     share       ms      events    ns/event  node\n";
+        Print(os, Ranked(byNode), total, rows, [](uint32_t context) {
+            return context == Simulator::NO_CONTEXT ? std::string("none")
+                                                    : "node " + std::to_string(context);
+        });
+    }
+
+    /// Folded stacks: "root;type;node microseconds" per (type, node).
+    static bool WriteFolded(const std::string& filename, const std::string& root)
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            return false;
+        }
+        std::unordered_map<const std::type_info*, std::string> names;
+        for (const auto& [key, cost] : Merge())
+        {
+            auto it = names.find(key.type);
+            if (it == names.end())
+            {
+                it = names.emplace(key.type, Name(key.type)).first;
+            }
+            const uint64_t us = (cost.ns + 500) / 1000;
+            if (us == 0)
+            {
+                continue;
+            }
+            out << root << ";" << it->second << ";";
+            if (key.context == Simulator::NO_CONTEXT)
+            {
+                out << "none";
+            }
+            else
+            {
+                out << "node " << key.context;
+            }
+            out << " " << us << "\n";
+        }
+        return true;
+    }
+
+  private:
+    struct Tables
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Table>> tables;
+    };
+
+    static Tables& Registry()
+    {
+        static Tables registry;
+        return registry;
+    }
+
+    static Table* Register()
+    {
+        std::lock_guard<std::mutex> lock(Registry().mutex);
+        Registry().tables.push_back(std::make_unique<Table>());
+        return Registry().tables.back().get();
+    }
+
+    static void Accumulate(Cost& sum, const Cost& cost)
+    {
+        sum.count += cost.count;
+        sum.ns += cost.ns;
+    }
+
+    template <typename K>
+    static std::vector<std::pair<K, Cost>> Ranked(const std::map<K, Cost>& costs)
+    {
+        std::vector<std::pair<K, Cost>> ranked(costs.begin(), costs.end());
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.second.ns > b.second.ns;
+        });
+        return ranked;
+    }
+
+    template <typename K, typename Label>
+    static void Print(std::ostream& os,
+                      const std::vector<std::pair<K, Cost>>& ranked,
+                      const Cost& total,
+                      size_t rows,
+                      Label label)
+    {
+        for (size_t i = 0; i < ranked.size() && i < rows; i++)
+        {
+            const Cost& cost = ranked[i].second;
+            char line[96];
+            std::snprintf(line,
+                          sizeof(line),
+                          "  %4zu  %7.2f%%  %9.1f  %10llu  %10.0f  ",
+                          i + 1,
+                          total.ns ? 100.0 * cost.ns / total.ns : 0.0,
+                          cost.ns * 1e-6,
+                          static_cast<unsigned long long>(cost.count),
+                          cost.count ? double(cost.ns) / cost.count : 0.0);
+            os << line << label(ranked[i].first) << "\n";
+        }
+    }
+};
+
+class ProfilingScheduler : public Scheduler
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::ProfilingScheduler")
+                                .SetParent<Scheduler>()
+                                .AddConstructor<ProfilingScheduler>();
+        return tid;
+    }
+
+    /// Make the simulator dispatch through a profiled MapScheduler.
+    static void Install()
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(GetTypeId());
+        Simulator::SetScheduler(factory);
+    }
+
+    ProfilingScheduler()
+        : m_inner(CreateObject<MapScheduler>())
+    {
+    }
+
+    void Insert(const Event& ev) override
+    {
+        const auto start = Clock::now();
+        m_inner->Insert(ev);
+        Scheduling(start);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_inner->IsEmpty();
+    }
+
+    Event PeekNext() const override
+    {
+        return m_inner->PeekNext();
+    }
+
+    Event RemoveNext() override
+    {
+        const auto start = Clock::now();
+        if (m_running)
+        {
+            // The previous event ran from m_last until now.
+            const uint64_t ns = Nanoseconds(start - m_last);
+            EventProfile::Add(m_running, m_context, ns - std::min(ns, m_nested));
+        }
+        Event ev = m_inner->RemoveNext();
+        m_running = &typeid(*ev.impl);
+        m_context = ev.key.m_context;
+        m_nested = 0;
+        m_last = Clock::now();
+        EventProfile::Add(nullptr, Simulator::NO_CONTEXT, Nanoseconds(m_last - start));
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        const auto start = Clock::now();
+        m_inner->Remove(ev);
+        Scheduling(start);
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_inner = nullptr;
+        Scheduler::DoDispose();
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t Nanoseconds(Clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    /// Charge scheduler work started at start, and keep it off the running event.
+    void Scheduling(Clock::time_point start)
+    {
+        const uint64_t ns = Nanoseconds(Clock::now() - start);
+        EventProfile::Add(nullptr, Simulator::NO_CONTEXT, ns);
+        m_nested += ns;
+    }
+
+    Ptr<Scheduler> m_inner;
+    const std::type_info* m_running = nullptr; //!< event dispatched last
+    uint32_t m_context = 0;
+    Clock::time_point m_last;                  //!< when it was dispatched
+    uint64_t m_nested = 0;                     //!< scheduler ns since then
+};
+
+} // namespace ns3
+
+#endif /* PROFILING_SCHEDULER_H */
@@ -8,10 +8,182 @@
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-module.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "flow-sampler.h"
+#include "latency-tracker.h"
+#include "packet-trace-sink.h"
+#include "position-trace.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("Third2Saturation");
 
+// Compteurs de la sonde en cours (mode recherche de saturation)
+struct ProbeCounters
+{
+    uint64_t firstUid = 0; // uid du premier paquet de la sonde
+    uint64_t txPackets = 0;
+    uint64_t rxPackets = 0;
+    uint64_t rxBytes = 0;
+    uint64_t linkBytes = 0;
+};
+
+static ProbeCounters g_probe;
+
+static void
+ProbeClientTx(Ptr<const Packet> packet)
+{
+    if (g_probe.txPackets++ == 0)
+    {
+        g_probe.firstUid = packet->GetUid();
+    }
+}
+
+// Les uid croissent : un paquet d'une sonde précédente encore en route
+// après sa vidange est plus ancien que le premier de la sonde en cours et
+// n'est pas compté.
+static void
+ProbeServerRx(Ptr<const Packet> packet)
+{
+    if (g_probe.txPackets == 0 || packet->GetUid() < g_probe.firstUid)
+    {
+        return;
+    }
+    g_probe.rxPackets++;
+    g_probe.rxBytes += packet->GetSize();
+}
+
+static void
+ProbeLinkTx(Ptr<const Packet> packet)
+{
+    if (g_probe.txPackets == 0 || packet->GetUid() < g_probe.firstUid)
+    {
+        return;
+    }
+    g_probe.linkBytes += packet->GetSize();
+}
+
+/**
+ * Recherche du point de saturation sur la topologie déjà construite :
+ * chaque sonde installe un nouveau client écho pendant probeDuration,
+ * puis laisse le réseau se vider avant de mesurer les pertes. L'intervalle
+ * entre paquets est ensuite coupé en deux (moyenne géométrique) entre le
+ * plus petit intervalle sans saturation et le plus grand saturé.
+ */
+static void
+SaturationSearch(Ptr<Node> client,
+                 Ptr<Node> server,
+                 Ipv4Address serverAddress,
+                 Ptr<NetDevice> bottleneck,
+                 uint32_t packetSize,
+                 double lossThreshold,
+                 uint32_t probes,
+                 double probeDuration,
+                 double minIntervalUs,
+                 double maxIntervalUs)
+{
+    uint16_t port = 9;
+    UdpEchoServerHelper echoServer(port);
+    ApplicationContainer serverApp = echoServer.Install(server);
+    serverApp.Start(Seconds(1.0));
+    serverApp.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&ProbeServerRx));
+    bottleneck->TraceConnectWithoutContext("PhyTxEnd", MakeCallback(&ProbeLinkTx));
+
+    // Association WiFi et ARP avant la première sonde, comme en mode normal
+    Simulator::Stop(Seconds(2.0));
+    Simulator::Run();
+
+    const double drain = 1.0;
+    double passing = 0;     // plus petit intervalle sous le seuil
+    double failing = 0;     // plus grand intervalle au-dessus du seuil
+    double bestGoodput = 0;
+    double bestLink = 0;
+
+    std::cout << "\n  sonde  intervalle(µs)  offert(Mbps)  pertes(%)  reçu(Mbps)  P2P(Mbps)\n";
+    for (uint32_t probe = 0; probe < probes; ++probe)
+    {
+        double intervalUs;
+        if (probe == 0)
+        {
+            intervalUs = maxIntervalUs;
+        }
+        else if (probe == 1 && passing > 0)
+        {
+            intervalUs = minIntervalUs;
+        }
+        else if (passing > 0 && failing > 0)
+        {
+            intervalUs = std::sqrt(passing * failing);
+        }
+        else
+        {
+            break;
+        }
+
+        g_probe = ProbeCounters();
+        UdpEchoClientHelper echoClient(serverAddress, port);
+        echoClient.SetAttribute("MaxPackets", UintegerValue(0));
+        echoClient.SetAttribute("Interval", TimeValue(MicroSeconds(intervalUs)));
+        echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
+        ApplicationContainer clientApp = echoClient.Install(client);
+        clientApp.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&ProbeClientTx));
+        // Démarrage et arrêt relatifs à l'installation en cours de simulation
+        clientApp.Start(Seconds(0));
+        clientApp.Stop(Seconds(probeDuration));
+
+        Simulator::Stop(Seconds(probeDuration + drain));
+        Simulator::Run();
+
+        double offered = packetSize * 8.0 / intervalUs;
+        double loss = 100.0;
+        if (g_probe.txPackets > 0)
+        {
+            uint64_t lost = g_probe.txPackets - std::min(g_probe.rxPackets, g_probe.txPackets);
+            loss = 100.0 * lost / g_probe.txPackets;
+        }
+        double goodput = g_probe.rxBytes * 8.0 / probeDuration / 1e6;
+        double link = g_probe.linkBytes * 8.0 / probeDuration / 1e6;
+        std::cout << "  " << std::setw(5) << probe + 1 << "  " << std::setw(14) << intervalUs
+                  << "  " << std::setw(12) << offered << "  " << std::setw(9) << loss
+                  << "  " << std::setw(10) << goodput << "  " << std::setw(9) << link << "\n";
+
+        if (loss <= lossThreshold)
+        {
+            passing = intervalUs;
+            if (goodput > bestGoodput)
+            {
+                bestGoodput = goodput;
+                bestLink = link;
+            }
+        }
+        else
+        {
+            failing = intervalUs;
+        }
+    }
+
+    std::cout << "\n";
+    if (passing == 0)
+    {
+        std::cout << "Saturé dès " << maxIntervalUs << " µs : augmenter maxIntervalUs\n";
+    }
+    else if (failing == 0)
+    {
+        std::cout << "Pas de saturation jusqu'à " << minIntervalUs << " µs : diminuer minIntervalUs\n";
+    }
+    else
+    {
+        std::cout << "Saturation entre " << passing << " et " << failing << " µs (seuil "
+                  << lossThreshold << " % de pertes)\n";
+        std::cout << "  Charge offerte max : " << packetSize * 8.0 / passing << " Mbps\n";
+    }
+    std::cout << "  Débit de saturation reçu : " << bestGoodput << " Mbps"
+              << " | lien P2P : " << bestLink << " Mbps\n";
+}
+
 int main(int argc, char *argv[])
 {
     bool verbose = true;
@@ -22,6 +194,19 @@ int main(int argc, char *argv[])
     uint32_t intervalUs = 1000000;  // Valeur par défaut
     uint32_t packetSize = 1024;
     DataRate cbrRate("6Mbps");       
+    std::string positionTrace = "";
+    double positionInterval = 0.1;
+    bool search = false;
+    double lossThreshold = 1.0;
+    uint32_t probes = 8;
+    double probeDuration = 2.0;
+    double minIntervalUs = 50;
+    double maxIntervalUs = 100000;
+    double sampleInterval = 0;
+    std::string sampleFile = "saturation_samples.csv";
+    double latencyInterval = 0;
+    std::string latencyFile = "saturation_latency.csv";
+    std::string traceFormat = "ascii";
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nWifi", "Nombre de STA WiFi", nWifi);
@@ -32,6 +217,19 @@ int main(int argc, char *argv[])
     cmd.AddValue("cbrRate", "Débit CBR pour le mode cbr", cbrRate);
     cmd.AddValue("tracing", "Activer pcap + flowmonitor", tracing);
     cmd.AddValue("verbose", "Logs des applications", verbose);
+    cmd.AddValue("positionTrace", "Fichier des positions des STA (time,id,x,y)", positionTrace);
+    cmd.AddValue("positionInterval", "Période d'échantillonnage des positions (s)", positionInterval);
+    cmd.AddValue("search", "Rechercher le point de saturation par dichotomie", search);
+    cmd.AddValue("lossThreshold", "Recherche : taux de pertes (%) définissant la saturation", lossThreshold);
+    cmd.AddValue("probes", "Recherche : nombre de sondes", probes);
+    cmd.AddValue("probeDuration", "Recherche : durée de trafic par sonde (s)", probeDuration);
+    cmd.AddValue("minIntervalUs", "Recherche : plus petit intervalle testé (µs)", minIntervalUs);
+    cmd.AddValue("maxIntervalUs", "Recherche : plus grand intervalle testé (µs)", maxIntervalUs);
+    cmd.AddValue("sampleInterval", "Période des séries temporelles par flux (s, 0 = désactivé)", sampleInterval);
+    cmd.AddValue("sampleFile", "Fichier CSV des séries temporelles par flux", sampleFile);
+    cmd.AddValue("latencyInterval", "Période des percentiles de latence en continu (s, 0 = fin seulement)", latencyInterval);
+    cmd.AddValue("latencyFile", "Fichier CSV des percentiles de latence par intervalle", latencyFile);
+    cmd.AddValue("traceFormat", "Trace des paquets avec tracing : ascii (tracemetrics-wifi.tr) ou binary (tracemetrics.ptr)", traceFormat);
     cmd.Parse(argc, argv);
     if (mode == "low")
     {
@@ -139,6 +337,15 @@ int main(int argc, char *argv[])
 
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
+    if (search)
+    {
+        SaturationSearch(wifiStaNodes.Get(nWifi - 1), csmaNodes.Get(nCsma), csmaIf.GetAddress(nCsma),
+                         p2pDevices.Get(0), packetSize, lossThreshold, probes, probeDuration,
+                         minIntervalUs, maxIntervalUs);
+        Simulator::Destroy();
+        return 0;
+    }
+
     // ========================================
     // APPLICATIONS SELON LE MODE
     // ========================================
@@ -162,25 +369,61 @@ int main(int argc, char *argv[])
 
     NS_LOG_UNCOND("Applications configurées");
 
+    // Latence par paquet : aller (serveur) et aller-retour (client)
+    LatencyTracker latency({"one-way", "round-trip"});
+    latency.WatchUdpEcho(clientApps, serverApps, "echo");
+    if (latencyInterval > 0)
+    {
+        latency.StartStreaming(Seconds(latencyInterval), latencyFile);
+    }
+
     // ========================================
     // Tracing + FlowMonitor
     // ========================================
+    PacketTraceSink packetTrace;
     if (tracing)
     {
         p2p.EnablePcapAll("tracemetrics", true);
         csma.EnablePcapAll("tracemetrics", true);
         phy.EnablePcapAll("tracemetrics", true);
-        AsciiTraceHelper ascii;
-        phy.EnableAsciiAll(ascii.CreateFileStream("tracemetrics-wifi.tr"));
+        if (traceFormat == "binary")
+        {
+            // Enregistrements binaires de 32 octets, lus par trace_dump
+            packetTrace.Open("tracemetrics.ptr");
+            packetTrace.Watch(NodeContainer::GetGlobal());
+        }
+        else
+        {
+            AsciiTraceHelper ascii;
+            phy.EnableAsciiAll(ascii.CreateFileStream("tracemetrics-wifi.tr"));
+        }
+    }
+
+    PositionTraceWriter positions;
+    if (!positionTrace.empty())
+    {
+        positions.Start(wifiStaNodes, Seconds(positionInterval), positionTrace);
     }
 
     FlowMonitorHelper flowmon;
     Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
+    FlowSampler sampler;
+    if (sampleInterval > 0)
+    {
+        sampler.Start(monitor, Seconds(sampleInterval), sampleFile);
+    }
+
     Simulator::Stop(Seconds(20.0));
     
     NS_LOG_UNCOND("Lancement de la simulation...");
     Simulator::Run();
+    sampler.Flush();
+    if (packetTrace.GetCount() > 0)
+    {
+        NS_LOG_UNCOND("Trace binaire : " << packetTrace.GetCount() << " événements tracés");
+    }
+    packetTrace.Close();
     NS_LOG_UNCOND("Simulation terminée");
 
     // ========================================
@@ -218,6 +461,7 @@ int main(int argc, char *argv[])
     }
 
     std::cout << "Nombre total de flux: " << stats.size() << "\n";
+    latency.Report(std::cout);
     std::cout << "============================================================\n";
 
     monitor->SerializeToXmlFile("saturation_flowmon.xml", true, true);
@@ -8,6 +8,11 @@
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-module.h"
 
+#include "fluid-model.h"
+#include "traffic-matrix.h"
+
+#include <fstream>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("Third3");
@@ -22,6 +27,10 @@ int main(int argc, char *argv[])
     uint32_t intervalUs = 1000000;
     uint32_t packetSize = 1024;
     DataRate cbrRate("6Mbps");       
+    std::string trafficFile;
+    bool fluid = false;
+    bool calibrate = false;
+    std::string calibrationFile = "fluid_calibration.csv";
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nWifi", "Nombre de STA WiFi", nWifi);
@@ -32,6 +41,10 @@ int main(int argc, char *argv[])
     cmd.AddValue("cbrRate", "Débit CBR pour le mode cbr", cbrRate);
     cmd.AddValue("tracing", "Activer pcap + flowmonitor", tracing);
     cmd.AddValue("verbose", "Logs des applications", verbose);
+    cmd.AddValue("traffic", "Matrice de trafic CSV remplaçant l'écho (nœuds par identifiant ns-3)", trafficFile);
+    cmd.AddValue("fluid", "Répondre avec le modèle fluide (Bianchi + file P2P) sans simulation paquet", fluid);
+    cmd.AddValue("calibrate", "Simuler et comparer au modèle fluide (une ligne par point dans calibrationFile ; grille : fluid_calibration.py)", calibrate);
+    cmd.AddValue("calibrationFile", "CSV de calibration du modèle fluide", calibrationFile);
     cmd.Parse(argc, argv);
 
     // Configuration de l'intervalle selon le mode
@@ -48,6 +61,34 @@ int main(int argc, char *argv[])
         intervalUs = 500;       // 500 µs
     }
 
+    // Modèle fluide : toute la charge offerte (8 * packetSize / intervalUs)
+    // répartie sur les STA, renvoyée en écho par le serveur.
+    FluidInput fluidInput;
+    fluidInput.stations = nWifi;
+    fluidInput.offeredBps = 8e6 * packetSize / intervalUs;
+    fluidInput.packetSize = packetSize;
+    FluidResult fluidResult = SolveFluid(fluidInput);
+    if ((fluid || calibrate) && !trafficFile.empty())
+    {
+        NS_FATAL_ERROR("Le modèle fluide ne couvre que le trafic d'écho (sans --traffic)");
+    }
+    if (fluid)
+    {
+        std::cout << "=== MODÈLE FLUIDE - Mode = " << mode << " | nWifi = " << nWifi << " ===\n";
+        std::cout << "  Attention : modèle non calibré, écarts au niveau paquet inconnus\n"
+                  << "  (les mesurer avec fluid_calibration.py)\n";
+        std::cout << "  Charge offerte   : " << fluidInput.offeredBps / 1e6 << " Mbps\n";
+        std::cout << "  Capacité WiFi    : " << fluidResult.cellFramesPerSecond << " trames/s\n";
+        std::cout << "  Débit vers l'AP  : " << fluidResult.uplinkBps / 1e6 << " Mbps\n";
+        std::cout << "  Débit P2P        : " << fluidResult.p2pBps / 1e6 << " Mbps\n";
+        std::cout << "  Débit écho       : " << fluidResult.echoBps / 1e6 << " Mbps\n";
+        std::cout << "  Pertes WiFi/P2P  : " << 100 * fluidResult.wifiLoss << " % / "
+                  << 100 * fluidResult.p2pLoss << " %\n";
+        std::cout << "  Pertes totales   : " << 100 * fluidResult.loss << " %\n";
+        std::cout << "  Délai estimé     : " << fluidResult.delay * 1e3 << " ms\n";
+        return 0;
+    }
+
     if (verbose)
     {
         LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
@@ -145,29 +186,45 @@ int main(int argc, char *argv[])
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     uint16_t port = 9;
     ApplicationContainer clientApps, serverApps;
+    Time stopTime = Seconds(35.0);  // 31s + marge de 4s
 
-    UdpEchoServerHelper echoServer(port);
-    serverApps = echoServer.Install(csmaNodes.Get(nCsma));
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(35.0));
-    uint32_t adjustedInterval = intervalUs * nWifi;
-    NS_LOG_UNCOND("Intervalle par nœud ajusté: " << adjustedInterval << " µs");
-    NS_LOG_UNCOND("Charge totale théorique: ~" << (8.0 * packetSize / adjustedInterval) << " Mbps");
-    for (uint32_t i = 0; i < nWifi; i++)
+    TrafficMatrix traffic;
+    if (!trafficFile.empty())
     {
-        UdpEchoClientHelper echoClient(csmaIf.GetAddress(nCsma), port);
-        echoClient.SetAttribute("MaxPackets", UintegerValue(100000));
-        echoClient.SetAttribute("Interval", TimeValue(MicroSeconds(adjustedInterval)));
-        echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
+        std::string error;
+        if (!LoadTrafficMatrix(trafficFile, traffic, &error))
+        {
+            NS_FATAL_ERROR("Erreur dans le fichier de trafic : " << error);
+        }
+        stopTime = std::max(stopTime, traffic.GetEnd() + Seconds(4.0));
+        clientApps = traffic.Install(NodeContainer::GetGlobal(), port, Seconds(1.0), stopTime);
+        NS_LOG_UNCOND("Applications configurées: " << traffic.Size() << " flux de " << trafficFile);
+    }
+    else
+    {
+        UdpEchoServerHelper echoServer(port);
+        serverApps = echoServer.Install(csmaNodes.Get(nCsma));
+        serverApps.Start(Seconds(1.0));
+        serverApps.Stop(Seconds(35.0));
+        uint32_t adjustedInterval = intervalUs * nWifi;
+        NS_LOG_UNCOND("Intervalle par nœud ajusté: " << adjustedInterval << " µs");
+        NS_LOG_UNCOND("Charge totale théorique: ~" << (8.0 * packetSize / adjustedInterval) << " Mbps");
+        for (uint32_t i = 0; i < nWifi; i++)
+        {
+            UdpEchoClientHelper echoClient(csmaIf.GetAddress(nCsma), port);
+            echoClient.SetAttribute("MaxPackets", UintegerValue(100000));
+            echoClient.SetAttribute("Interval", TimeValue(MicroSeconds(adjustedInterval)));
+            echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
         
-        ApplicationContainer clientApp = echoClient.Install(wifiStaNodes.Get(i));
-        clientApp.Start(Seconds(2.0 + i * 0.01));  // Décalage de 10ms entre clients
-        clientApp.Stop(Seconds(31.0));
+            ApplicationContainer clientApp = echoClient.Install(wifiStaNodes.Get(i));
+            clientApp.Start(Seconds(2.0 + i * 0.01));  // Décalage de 10ms entre clients
+            clientApp.Stop(Seconds(31.0));
         
-        clientApps.Add(clientApp);
-    }
+            clientApps.Add(clientApp);
+        }
 
-    NS_LOG_UNCOND("Applications configurées: " << nWifi << " clients WiFi actifs");
+        NS_LOG_UNCOND("Applications configurées: " << nWifi << " clients WiFi actifs");
+    }
 
     // Tracing + FlowMonitor
     if (tracing)
@@ -182,7 +239,7 @@ int main(int argc, char *argv[])
     FlowMonitorHelper flowmon;
     Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
-    Simulator::Stop(Seconds(35.0));  // 31s + marge de 4s
+    Simulator::Stop(stopTime);
     
     NS_LOG_UNCOND("Lancement de la simulation...");
     Simulator::Run();
@@ -223,6 +280,52 @@ int main(int argc, char *argv[])
     std::cout << "Nombre total de flux: " << stats.size() << "\n";
     std::cout << "============================================================\n";
 
+    if (calibrate)
+    {
+        // Requêtes : flux vers le serveur ; débit utile (sans en-têtes UDP/IP).
+        Ipv4Address server = csmaIf.GetAddress(nCsma);
+        double p2pBps = 0;
+        double echoBps = 0;
+        uint64_t requestsTx = 0;
+        uint64_t requestsRx = 0;
+        for (const auto& [id, st] : stats)
+        {
+            Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(id);
+            Time duration = st.timeLastRxPacket - st.timeFirstTxPacket;
+            double bps = duration.IsStrictlyPositive() ? st.rxPackets * 8.0 * packetSize / duration.GetSeconds() : 0;
+            if (t.destinationAddress == server)
+            {
+                p2pBps += bps;
+                requestsTx += st.txPackets;
+                requestsRx += st.rxPackets;
+            }
+            else if (t.sourceAddress == server)
+            {
+                echoBps += bps;
+            }
+        }
+        double loss = requestsTx ? 1.0 - double(requestsRx) / requestsTx : 0;
+
+        std::cout << "CALIBRATION (fluide / paquet)\n";
+        std::cout << "  Débit P2P  : " << fluidResult.p2pBps / 1e6 << " / " << p2pBps / 1e6 << " Mbps\n";
+        std::cout << "  Débit écho : " << fluidResult.echoBps / 1e6 << " / " << echoBps / 1e6 << " Mbps\n";
+        std::cout << "  Pertes     : " << 100 * fluidResult.loss << " / " << 100 * loss << " %\n";
+
+        std::ifstream existing(calibrationFile);
+        bool header = !existing.good() || existing.peek() == std::ifstream::traits_type::eof();
+        existing.close();
+        std::ofstream out(calibrationFile, std::ios::app);
+        if (header)
+        {
+            out << "nWifi,mode,interval_us,packet_size,offered_mbps,fluid_p2p_mbps,packet_p2p_mbps,"
+                   "fluid_echo_mbps,packet_echo_mbps,fluid_loss,packet_loss\n";
+        }
+        out << nWifi << "," << mode << "," << intervalUs << "," << packetSize << ","
+            << fluidInput.offeredBps / 1e6 << "," << fluidResult.p2pBps / 1e6 << "," << p2pBps / 1e6 << ","
+            << fluidResult.echoBps / 1e6 << "," << echoBps / 1e6 << "," << fluidResult.loss << "," << loss
+            << "\n";
+    }
+
     monitor->SerializeToXmlFile("saturation_flowmon.xml", true, true);
     Simulator::Destroy();
     return 0;
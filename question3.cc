@@ -7,7 +7,12 @@
 #include "ns3/csma-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-module.h"
-#include "ns3/netanim-module.h"    
+
+#include "cached-propagation-loss.h"
+#include "flow-sampler.h"
+#include "latency-tracker.h"
+#include "netanim-stream.h"
+#include "traffic-matrix.h"
 
 using namespace ns3;
 
@@ -21,12 +26,32 @@ int main(int argc, char *argv[])
     std::string mode = "medium";
     uint32_t intervalUs = 10000; 
     uint32_t packetSize = 1024;
+    bool cacheLoss = false;
+    double sampleInterval = 0;
+    std::string sampleFile = "tp2_samples.csv";
+    double latencyInterval = 0;
+    std::string latencyFile = "tp2_latency.csv";
+    std::string trafficFile;
+    bool animation = false;
+    uint32_t animSample = 1;
+    bool animMeta = true;
+    bool animGzip = false;
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nWifi", "Nombre de stations WiFi", nWifi);
     cmd.AddValue("nCsma", "Nombre de nœuds CSMA", nCsma);
     cmd.AddValue("mode", "Mode de charge: low, medium, high, extreme", mode);
     cmd.AddValue("verbose", "Activer les logs applicatifs", verbose);
+    cmd.AddValue("cacheLoss", "Mémoriser la perte de propagation par paire de nœuds", cacheLoss);
+    cmd.AddValue("sampleInterval", "Période des séries temporelles par flux (s, 0 = désactivé)", sampleInterval);
+    cmd.AddValue("sampleFile", "Fichier CSV des séries temporelles par flux", sampleFile);
+    cmd.AddValue("latencyInterval", "Période des percentiles de latence en continu (s, 0 = fin seulement)", latencyInterval);
+    cmd.AddValue("latencyFile", "Fichier CSV des percentiles de latence par intervalle", latencyFile);
+    cmd.AddValue("traffic", "Matrice de trafic CSV remplaçant l'écho (nœuds par identifiant ns-3)", trafficFile);
+    cmd.AddValue("animation", "Écrire le fichier NetAnim animation_tp2.xml", animation);
+    cmd.AddValue("animSample", "NetAnim : dessiner un paquet sur N", animSample);
+    cmd.AddValue("animMeta", "NetAnim : joindre les en-têtes des paquets dessinés", animMeta);
+    cmd.AddValue("animGzip", "NetAnim : compresser le fichier avec gzip", animGzip);
     cmd.Parse(argc, argv);
 
     // Configuration de l'intervalle selon le mode
@@ -75,7 +100,14 @@ int main(int argc, char *argv[])
     // WiFi 802.11a
     YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default();
     YansWifiPhyHelper phy;
-    phy.SetChannel(wifiChannel.Create());
+    Ptr<YansWifiChannel> yansChannel = wifiChannel.Create();
+    if (cacheLoss)
+    {
+        // Nœuds immobiles : la perte log-distance n'est calculée qu'une fois par paire.
+        yansChannel->SetPropagationLossModel(
+            CreateCachedLoss(CreateObject<LogDistancePropagationLossModel>()));
+    }
+    phy.SetChannel(yansChannel);
 
     WifiHelper wifi;
     wifi.SetStandard(WIFI_STANDARD_80211a);
@@ -132,55 +164,85 @@ int main(int argc, char *argv[])
     // Applications (charge normalisée)
     // ========================
     uint16_t port = 9;
-    UdpEchoServerHelper echoServer(port);
-    ApplicationContainer serverApps = echoServer.Install(csmaNodes.Get(nCsma - 1));
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(35.0));
-
-    // Normalisation de la charge totale
-    uint32_t adjustedInterval = intervalUs * nWifi;
-    NS_LOG_UNCOND("Intervalle ajusté par STA: " << adjustedInterval << " µs");
-    NS_LOG_UNCOND("Charge totale offerte estimée: ~" << (8.0 * packetSize * nWifi / adjustedInterval) << " Mbps");
-
+    ApplicationContainer serverApps;
     ApplicationContainer clientApps;
-    for (uint32_t i = 0; i < nWifi; ++i)
+    Time stopTime = Seconds(36.0);
+    TrafficMatrix traffic;
+    LatencyTracker latency({"one-way", "round-trip"});
+    if (!trafficFile.empty())
     {
-        UdpEchoClientHelper echoClient(csmaIf.GetAddress(nCsma - 1), port);
-        echoClient.SetAttribute("MaxPackets", UintegerValue(100000));
-        echoClient.SetAttribute("Interval", TimeValue(MicroSeconds(adjustedInterval)));
-        echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
-
-        ApplicationContainer clientApp = echoClient.Install(wifiStaNodes.Get(i));
-        clientApp.Start(Seconds(2.0 + i * 0.01));  // Décalage pour éviter burst initial
-        clientApp.Stop(Seconds(31.0));
-        clientApps.Add(clientApp);
+        std::string error;
+        if (!LoadTrafficMatrix(trafficFile, traffic, &error))
+        {
+            NS_FATAL_ERROR("Erreur dans le fichier de trafic : " << error);
+        }
+        stopTime = std::max(stopTime, traffic.GetEnd() + Seconds(5.0));
+        clientApps = traffic.Install(NodeContainer::GetGlobal(), port, Seconds(1.0), stopTime);
+        NS_LOG_UNCOND("Trafic : " << traffic.Size() << " flux de " << trafficFile);
+    }
+    else
+    {
+        UdpEchoServerHelper echoServer(port);
+        serverApps = echoServer.Install(csmaNodes.Get(nCsma - 1));
+        serverApps.Start(Seconds(1.0));
+        serverApps.Stop(Seconds(35.0));
+
+        // Normalisation de la charge totale
+        uint32_t adjustedInterval = intervalUs * nWifi;
+        NS_LOG_UNCOND("Intervalle ajusté par STA: " << adjustedInterval << " µs");
+        NS_LOG_UNCOND("Charge totale offerte estimée: ~" << (8.0 * packetSize * nWifi / adjustedInterval) << " Mbps");
+
+        for (uint32_t i = 0; i < nWifi; ++i)
+        {
+            UdpEchoClientHelper echoClient(csmaIf.GetAddress(nCsma - 1), port);
+            echoClient.SetAttribute("MaxPackets", UintegerValue(100000));
+            echoClient.SetAttribute("Interval", TimeValue(MicroSeconds(adjustedInterval)));
+            echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
+
+            ApplicationContainer clientApp = echoClient.Install(wifiStaNodes.Get(i));
+            clientApp.Start(Seconds(2.0 + i * 0.01));  // Décalage pour éviter burst initial
+            clientApp.Stop(Seconds(31.0));
+            clientApps.Add(clientApp);
+        }
+
+        // Latence par paquet : aller (serveur) et aller-retour (client), par STA
+        latency.WatchUdpEcho(clientApps, serverApps, "STA");
+        if (latencyInterval > 0)
+        {
+            latency.StartStreaming(Seconds(latencyInterval), latencyFile);
+        }
     }
 
     // ========================
     // NetAnim
     // ========================
-    AnimationInterface anim("animation_tp2.xml");
-    anim.EnablePacketMetadata(true);
-    anim.SetMobilityPollInterval(Seconds(0.5));
-
-    // Descriptions et couleurs
-    anim.UpdateNodeDescription(wifiApNode.Get(0), "AP-WiFi");
-    anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);        // Rouge
-
-    for (uint32_t i = 0; i < wifiStaNodes.GetN(); ++i)
+    StreamingAnimation anim;
+    if (animation)
     {
-        anim.UpdateNodeDescription(wifiStaNodes.Get(i), "STA" + std::to_string(i));
-        anim.UpdateNodeColor(wifiStaNodes.Get(i), 0, 0, 255);  // Bleu
-    }
-
-    anim.UpdateNodeDescription(p2pNodes.Get(1), "Routeur");
-    anim.UpdateNodeColor(p2pNodes.Get(1), 255, 255, 0);        // Jaune
-
-    for (uint32_t i = 0; i < csmaNodes.GetN(); ++i)
-    {
-        std::string name = (i == csmaNodes.GetN() - 1) ? "Serveur" : "CSMA" + std::to_string(i);
-        anim.UpdateNodeDescription(csmaNodes.Get(i), name);
-        anim.UpdateNodeColor(csmaNodes.Get(i), 0, 255, 0);      // Vert
+        anim.EnablePacketMetadata(animMeta);
+        anim.SetMobilityPollInterval(Seconds(0.5));
+        anim.SetSampling(animSample);
+        anim.Open("animation_tp2.xml", animGzip);
+
+        // Descriptions et couleurs
+        anim.UpdateNodeDescription(wifiApNode.Get(0), "AP-WiFi");
+        anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);        // Rouge
+
+        for (uint32_t i = 0; i < wifiStaNodes.GetN(); ++i)
+        {
+            anim.UpdateNodeDescription(wifiStaNodes.Get(i), "STA" + std::to_string(i));
+            anim.UpdateNodeColor(wifiStaNodes.Get(i), 0, 0, 255);  // Bleu
+        }
+
+        anim.UpdateNodeDescription(p2pNodes.Get(1), "Routeur");
+        anim.UpdateNodeColor(p2pNodes.Get(1), 255, 255, 0);        // Jaune
+
+        for (uint32_t i = 0; i < csmaNodes.GetN(); ++i)
+        {
+            std::string name = (i == csmaNodes.GetN() - 1) ? "Serveur" : "CSMA" + std::to_string(i);
+            anim.UpdateNodeDescription(csmaNodes.Get(i), name);
+            anim.UpdateNodeColor(csmaNodes.Get(i), 0, 255, 0);      // Vert
+        }
     }
 
     // ========================
@@ -189,9 +251,17 @@ int main(int argc, char *argv[])
     FlowMonitorHelper flowmon;
     Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
-    Simulator::Stop(Seconds(36.0));
+    FlowSampler sampler;
+    if (sampleInterval > 0)
+    {
+        sampler.Start(monitor, Seconds(sampleInterval), sampleFile);
+    }
+
+    Simulator::Stop(stopTime);
     NS_LOG_UNCOND("Lancement de la simulation...");
     Simulator::Run();
+    sampler.Flush();
+    anim.Close();
 
     // ========================
     // Résultats FlowMonitor
@@ -216,9 +286,14 @@ int main(int argc, char *argv[])
                   << "Loss: " << lossRate << "% | "
                   << "Delay: " << (it->second.delaySum.GetSeconds() / it->second.rxPackets * 1000) << " ms\n";
     }
+    latency.Report(std::cout);
 
     monitor->SerializeToXmlFile("flowmon_tp2.xml", true, true);
     Simulator::Destroy();
-    NS_LOG_UNCOND("Simulation terminée. Fichier NetAnim: animation_tp2.xml");
+    NS_LOG_UNCOND("Simulation terminée.");
+    if (animation)
+    {
+        NS_LOG_UNCOND("Fichier NetAnim: " << anim.GetFilename() << " (" << anim.GetPackets() << " paquets)");
+    }
     return 0;
 }
@@ -10,38 +10,111 @@
  #include "ns3/point-to-point-module.h"
  #include "ns3/ssid.h"
  #include "ns3/yans-wifi-helper.h"
- #include "ns3/netanim-module.h"
  #include <fstream>
  #include <vector>
  
+ #include "latency-histogram.h"
+ #include "netanim-stream.h"
+ #include "position-trace.h"
+ 
  using namespace ns3;
  
  NS_LOG_COMPONENT_DEFINE("Question4");
  
- std::vector<double> g_delays;
- Time g_lastSend;
+ /**
+  * Sequence number and send time carried by each echo request, as a byte
+  * tag so that it survives every hop to the server.
+  */
+ class DelayTag : public Tag
+ {
+   public:
+     static TypeId GetTypeId()
+     {
+         static TypeId tid = TypeId("DelayTag").SetParent<Tag>().AddConstructor<DelayTag>();
+         return tid;
+     }
+ 
+     TypeId GetInstanceTypeId() const override
+     {
+         return GetTypeId();
+     }
+ 
+     uint32_t GetSerializedSize() const override
+     {
+         return 12;
+     }
+ 
+     void Serialize(TagBuffer i) const override
+     {
+         i.WriteU32(seq);
+         i.WriteU64(static_cast<uint64_t>(sent));
+     }
+ 
+     void Deserialize(TagBuffer i) override
+     {
+         seq = i.ReadU32();
+         sent = static_cast<int64_t>(i.ReadU64());
+     }
+ 
+     void Print(std::ostream& os) const override
+     {
+         os << "seq=" << seq << " sent=" << sent << "ns";
+     }
+ 
+     uint32_t seq = 0;
+     int64_t sent = 0; //!< ns
+ };
+ 
+ NS_OBJECT_ENSURE_REGISTERED(DelayTag);
+ 
+ /// Delay of packet seq in ns, -1 until it reaches the server; sized once.
+ std::vector<int64_t> g_delays;
+ uint32_t g_nextSeq = 0;
+ LatencyHistogram g_histogram;
  
  void TxTrace(Ptr<const Packet> packet)
  {
-     g_lastSend = Simulator::Now();
+     DelayTag tag;
+     tag.seq = g_nextSeq++;
+     tag.sent = Simulator::Now().GetNanoSeconds();
+     packet->AddByteTag(tag);
  }
  
  void RxTrace(Ptr<const Packet> packet)
  {
-     Time delay = Simulator::Now() - g_lastSend;
-     g_delays.push_back(delay.GetMilliSeconds());
+     DelayTag tag;
+     if (!packet->FindFirstMatchingByteTag(tag) || tag.seq >= g_delays.size() ||
+         g_delays[tag.seq] >= 0)
+     {
+         return;
+     }
+     int64_t delay = Simulator::Now().GetNanoSeconds() - tag.sent;
+     g_delays[tag.seq] = delay;
+     g_histogram.Record(delay);
  }
  
  int main(int argc, char* argv[])
  {
      uint32_t nWifi = 4;
      uint32_t nPackets = 10;
+     double interval = 1.0;
      bool tracing = true;
+     std::string positionTrace = "";
+     bool animation = false;
+     uint32_t animSample = 1;
+     bool animGzip = false;
+     double positionInterval = 0.1;
  
      CommandLine cmd(__FILE__);
      cmd.AddValue("nWifi", "Number of wifi STA devices per network (max 9)", nWifi);
-     cmd.AddValue("nPackets", "Number of packets to send (max 20)", nPackets);
+     cmd.AddValue("nPackets", "Number of packets to send", nPackets);
+     cmd.AddValue("interval", "Interval between packets (s)", interval);
      cmd.AddValue("tracing", "Enable pcap tracing", tracing);
+     cmd.AddValue("positionTrace", "Write STA positions (time,id,x,y) to this file", positionTrace);
+     cmd.AddValue("positionInterval", "Position sampling interval (s)", positionInterval);
+     cmd.AddValue("animation", "Write the NetAnim file q4-animation.xml", animation);
+     cmd.AddValue("animSample", "NetAnim: draw one packet in N", animSample);
+     cmd.AddValue("animGzip", "NetAnim: compress the file through gzip", animGzip);
      cmd.Parse(argc, argv);
  
      if (nWifi > 9)
@@ -49,11 +122,7 @@
          std::cout << "nWifi should be 9 or less" << std::endl;
          return 1;
      }
-     if (nPackets > 20)
-     {
-         std::cout << "nPackets should be 20 or less" << std::endl;
-         return 1;
-     }
+     g_delays.assign(nPackets, -1);
  
      std::cout << "Simulation: " << 2 * nWifi << " WiFi nodes (" << nWifi 
                << " per network), " << nPackets << " packets" << std::endl;
@@ -174,7 +243,7 @@
  
      UdpEchoClientHelper echoClient(wifi2Interfaces.GetAddress(nWifi - 1), 9);
      echoClient.SetAttribute("MaxPackets", UintegerValue(nPackets));
-     echoClient.SetAttribute("Interval", TimeValue(Seconds(1.0)));
+     echoClient.SetAttribute("Interval", TimeValue(Seconds(interval)));
      echoClient.SetAttribute("PacketSize", UintegerValue(1024));
  
      ApplicationContainer clientApps = echoClient.Install(wifiStaNodes1.Get(nWifi - 1));
@@ -198,12 +267,24 @@
          std::cout << "\nPcap files saved: q4.pcap , q4-wifi1.pcap , q4-wifi2.pcap \n";
      }
  
+     PositionTraceWriter positions;
+     if (!positionTrace.empty())
+     {
+         NodeContainer stations(wifiStaNodes1, wifiStaNodes2);
+         positions.Start(stations, Seconds(positionInterval), positionTrace);
+     }
+ 
      // NetAnim
-     AnimationInterface anim("q4-animation.xml");
-     anim.SetMaxPktsPerTraceFile(500000);
+     StreamingAnimation anim;
+     if (animation)
+     {
+         anim.SetSampling(animSample);
+         anim.Open("q4-animation.xml", animGzip);
+     }
  
      Simulator::Stop(Seconds(50.0));
      Simulator::Run();
+     anim.Close();
      Simulator::Destroy();
  
      // Save data
@@ -211,11 +292,24 @@
      dataFile << "# Packet Delay(ms)\n";
      for (size_t i = 0; i < g_delays.size(); i++)
      {
-         dataFile << (i + 1) << " " << g_delays[i] << "\n";
-         std::cout << "Packet " << (i + 1) << ": " << g_delays[i] << " ms\n";
+         if (g_delays[i] < 0)
+         {
+             continue;
+         }
+         dataFile << (i + 1) << " " << g_delays[i] / 1e6 << "\n";
+         if (nPackets <= 20)
+         {
+             std::cout << "Packet " << (i + 1) << ": " << g_delays[i] / 1e6 << " ms\n";
+         }
      }
      dataFile.close();
  
+     std::cout << "Received " << g_histogram.Count() << " of " << g_nextSeq << " packets sent\n";
+     std::cout << "Delay (ms): mean " << g_histogram.Mean() / 1e6 << ", p50 "
+               << g_histogram.Percentile(50) / 1e6 << ", p99 " << g_histogram.Percentile(99) / 1e6
+               << ", p99.9 " << g_histogram.Percentile(99.9) / 1e6 << ", max "
+               << g_histogram.Max() / 1e6 << "\n";
+ 
      // Gnuplot script
      std::ofstream gnuFile("plot.gnu");
      gnuFile << "set terminal png size 800,600\n";
@@ -238,7 +332,11 @@
          std::cout << "\nData saved: delay-data.dat (run 'gnuplot plot.gnu' manually)\n";
      }
  
-     std::cout << "NetAnim file: q4-animation.xml\n";
+     if (animation)
+     {
+         std::cout << "NetAnim file: " << anim.GetFilename() << " (" << anim.GetPackets()
+                   << " packets)\n";
+     }
  
      return 0;
  }
\ No newline at end of file
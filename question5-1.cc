@@ -11,9 +11,12 @@
 #include "ns3/ssid.h"
 #include "ns3/yans-wifi-helper.h"
 #include "ns3/flow-monitor-module.h"
-#include "ns3/netanim-module.h"
 #include <fstream>
 
+#include "cached-propagation-loss.h"
+#include "netanim-stream.h"
+#include "wifi-pcap-capture.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("MimoQ1");
@@ -22,10 +25,24 @@ int main(int argc, char *argv[])
 {
     uint32_t nStreams = 1;
     double duration = 10.0;
+    bool cacheLoss = false;
+    std::string pcap = "sampled";
+    uint32_t snapLen = 128;
+    uint32_t pcapSample = 1;
+    bool animation = false;
+    uint32_t animSample = 1;
+    bool animGzip = false;
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nStreams", "Number of spatial streams (1 or 2)", nStreams);
     cmd.AddValue("duration", "Simulation duration (seconds)", duration);
+    cmd.AddValue("cacheLoss", "Memoize propagation loss per node pair", cacheLoss);
+    cmd.AddValue("pcap", "Capture: full (whole frames), sampled (snapLen/pcapSample) or off", pcap);
+    cmd.AddValue("snapLen", "Sampled capture: bytes kept per frame (0 = whole frame)", snapLen);
+    cmd.AddValue("pcapSample", "Sampled capture: keep one frame in N of each flow", pcapSample);
+    cmd.AddValue("animation", "Write a NetAnim file", animation);
+    cmd.AddValue("animSample", "NetAnim: draw one packet in N", animSample);
+    cmd.AddValue("animGzip", "NetAnim: compress the file through gzip", animGzip);
     cmd.Parse(argc, argv);
 
     std::cout << "\n========================================\n";
@@ -41,7 +58,14 @@ int main(int argc, char *argv[])
     // Channel
     YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
     YansWifiPhyHelper phy;
-    phy.SetChannel(channel.Create());
+    Ptr<YansWifiChannel> yansChannel = channel.Create();
+    if (cacheLoss)
+    {
+        // Nodes never move: compute the default log-distance loss once per pair.
+        yansChannel->SetPropagationLossModel(
+            CreateCachedLoss(CreateObject<LogDistancePropagationLossModel>()));
+    }
+    phy.SetChannel(yansChannel);
 
     // WiFi 802.11n 5GHz
     WifiHelper wifi;
@@ -119,19 +143,47 @@ int main(int argc, char *argv[])
 
     // NetAnim
     std::string animFile = "mimo-q1-" + std::to_string(nStreams) + "stream.xml";
-    AnimationInterface anim(animFile);
-    anim.SetMaxPktsPerTraceFile(500000);
+    StreamingAnimation anim;
+    if (animation)
+    {
+        anim.SetSampling(animSample);
+        anim.Open(animFile, animGzip);
+
+        // Set node descriptions
+        anim.UpdateNodeDescription(wifiApNode.Get(0), "AP");
+        anim.UpdateNodeDescription(wifiStaNode.Get(0), "STA");
 
-    // Set node descriptions
-    anim.UpdateNodeDescription(wifiApNode.Get(0), "AP");
-    anim.UpdateNodeDescription(wifiStaNode.Get(0), "STA");
+        // Set node colors
+        anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);  // Red for AP
+        anim.UpdateNodeColor(wifiStaNode.Get(0), 0, 0, 255); // Blue for STA
+    }
 
-    // Set node colors
-    anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);  // Red for AP
-    anim.UpdateNodeColor(wifiStaNode.Get(0), 0, 0, 255); // Blue for STA
+    // Activation de Wireshark (avant Run, sinon les captures restent vides)
+    // ======================
+    std::string pcapPrefix = "mimo-q1-" + std::to_string(nStreams) + "stream";
+    WifiPcapCapture apCapture;
+    WifiPcapCapture staCapture;
+    if (pcap == "full")
+    {
+        phy.EnablePcap(pcapPrefix, apDevice.Get(0));
+        phy.EnablePcap(pcapPrefix + "-sta", staDevice.Get(0));
+    }
+    else if (pcap == "sampled")
+    {
+        // En-têtes seulement, écrits par un thread séparé
+        NS_ABORT_MSG_UNLESS(apCapture.Open(pcapPrefix + "-ap.pcap", snapLen, pcapSample),
+                            "Cannot create " << pcapPrefix << "-ap.pcap");
+        apCapture.Watch(apDevice.Get(0));
+        NS_ABORT_MSG_UNLESS(staCapture.Open(pcapPrefix + "-sta.pcap", snapLen, pcapSample),
+                            "Cannot create " << pcapPrefix << "-sta.pcap");
+        staCapture.Watch(staDevice.Get(0));
+    }
 
     Simulator::Stop(Seconds(duration + 1));
     Simulator::Run();
+    anim.Close();
+    apCapture.Close();
+    staCapture.Close();
 
     // Statistics
     monitor->CheckForLostPackets();
@@ -166,17 +218,23 @@ int main(int argc, char *argv[])
     outFile.close();
 
     std::cout << "Data saved to: mimo-results.txt\n";
-    std::cout << "NetAnim file: " << animFile << "\n";
-
-    // Activation de Wireshark
-    // ======================
-
-    // Capture sur l'interface AP
-    std::string pcapPrefix = "mimo-q1-" + std::to_string(nStreams) + "stream";
-    phy.EnablePcap(pcapPrefix, apDevice.Get(0));
-    phy.EnablePcap(pcapPrefix + "-sta", staDevice.Get(0));
+    if (animation)
+    {
+        std::cout << "NetAnim file: " << anim.GetFilename() << " (" << anim.GetPackets()
+                  << " packets)\n";
+    }
 
-    std::cout << "Fichiers PCAP générés : " << pcapPrefix << "*.pcap\n";
+    if (pcap == "sampled")
+    {
+        std::cout << "Trames capturées : " << apCapture.GetWritten() << "/" << apCapture.GetFrames()
+                  << " (AP), " << staCapture.GetWritten() << "/" << staCapture.GetFrames()
+                  << " (STA), attentes disque : "
+                  << apCapture.GetStalls() + staCapture.GetStalls() << "\n";
+    }
+    if (pcap != "off")
+    {
+        std::cout << "Fichiers PCAP générés : " << pcapPrefix << "*.pcap\n";
+    }
 
     Simulator::Destroy();
 
@@ -11,9 +11,14 @@
 #include "ns3/ssid.h"
 #include "ns3/yans-wifi-helper.h"
 #include "ns3/flow-monitor-module.h"
-#include "ns3/netanim-module.h"
+#include <chrono>
 #include <fstream>
 
+#include "cached-propagation-loss.h"
+#include "netanim-stream.h"
+#include "profiling-scheduler.h"
+#include "wifi-pcap-capture.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("MimoQ2");
@@ -23,13 +28,36 @@ int main(int argc, char *argv[])
     double distance = 5.0;
     uint32_t channelWidth = 20;
     double duration = 10.0;
+    bool cacheLoss = false;
+    std::string pcap = "off";
+    uint32_t snapLen = 128;
+    uint32_t pcapSample = 1;
+    bool animation = false;
+    uint32_t animSample = 1;
+    bool animGzip = false;
+    bool profile = false;
+    std::string profileFile = "mimo-q2-profile.folded";
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("distance", "Distance between STA and AP (meters)", distance);
     cmd.AddValue("channelWidth", "Channel width: 20 or 40 MHz", channelWidth);
     cmd.AddValue("duration", "Simulation duration (seconds)", duration);
+    cmd.AddValue("cacheLoss", "Memoize propagation loss per node pair", cacheLoss);
+    cmd.AddValue("pcap", "Capture: full (whole frames), sampled (snapLen/pcapSample) or off", pcap);
+    cmd.AddValue("snapLen", "Sampled capture: bytes kept per frame (0 = whole frame)", snapLen);
+    cmd.AddValue("pcapSample", "Sampled capture: keep one frame in N of each flow", pcapSample);
+    cmd.AddValue("animation", "Write a NetAnim file", animation);
+    cmd.AddValue("animSample", "NetAnim: draw one packet in N", animSample);
+    cmd.AddValue("animGzip", "NetAnim: compress the file through gzip", animGzip);
+    cmd.AddValue("profile", "Profile event dispatch per event type and node", profile);
+    cmd.AddValue("profileFile", "Profile: folded-stack file for flamegraph.pl", profileFile);
     cmd.Parse(argc, argv);
 
+    if (profile)
+    {
+        ProfilingScheduler::Install();
+    }
+
     std::cout << "\n========================================\n";
     std::cout << "MIMO Distance Test\n";
     std::cout << "Distance: " << distance << " m\n";
@@ -45,7 +73,14 @@ int main(int argc, char *argv[])
     // Channel
     YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
     YansWifiPhyHelper phy;
-    phy.SetChannel(channel.Create());
+    Ptr<YansWifiChannel> yansChannel = channel.Create();
+    if (cacheLoss)
+    {
+        // Nodes never move: compute the default log-distance loss once per pair.
+        yansChannel->SetPropagationLossModel(
+            CreateCachedLoss(CreateObject<LogDistancePropagationLossModel>()));
+    }
+    phy.SetChannel(yansChannel);
 
     // WiFi 802.11n 5GHz with 2x2 MIMO
     WifiHelper wifi;
@@ -122,19 +157,49 @@ int main(int argc, char *argv[])
     // NetAnim
     std::string animFile = "mimo-q2-" + std::to_string((int)distance) + "m-" +
                            std::to_string(channelWidth) + "mhz.xml";
-    AnimationInterface anim(animFile);
-    anim.SetMaxPktsPerTraceFile(500000);
+    StreamingAnimation anim;
+    if (animation)
+    {
+        anim.SetSampling(animSample);
+        anim.Open(animFile, animGzip);
 
-    // Set node descriptions
-    anim.UpdateNodeDescription(wifiApNode.Get(0), "AP");
-    anim.UpdateNodeDescription(wifiStaNode.Get(0), "STA");
+        // Set node descriptions
+        anim.UpdateNodeDescription(wifiApNode.Get(0), "AP");
+        anim.UpdateNodeDescription(wifiStaNode.Get(0), "STA");
 
-    // Set node colors
-    anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);  // Red for AP
-    anim.UpdateNodeColor(wifiStaNode.Get(0), 0, 0, 255); // Blue for STA
+        // Set node colors
+        anim.UpdateNodeColor(wifiApNode.Get(0), 255, 0, 0);  // Red for AP
+        anim.UpdateNodeColor(wifiStaNode.Get(0), 0, 0, 255); // Blue for STA
+    }
+
+    // Wireshark: with a 10 µs interval, prefer the sampled capture
+    std::string pcapPrefix = "mimo-q2-" + std::to_string((int)distance) + "m-" +
+                             std::to_string(channelWidth) + "mhz";
+    WifiPcapCapture apCapture;
+    WifiPcapCapture staCapture;
+    if (pcap == "full")
+    {
+        phy.EnablePcap(pcapPrefix, apDevice.Get(0));
+        phy.EnablePcap(pcapPrefix + "-sta", staDevice.Get(0));
+    }
+    else if (pcap == "sampled")
+    {
+        NS_ABORT_MSG_UNLESS(apCapture.Open(pcapPrefix + "-ap.pcap", snapLen, pcapSample),
+                            "Cannot create " << pcapPrefix << "-ap.pcap");
+        apCapture.Watch(apDevice.Get(0));
+        NS_ABORT_MSG_UNLESS(staCapture.Open(pcapPrefix + "-sta.pcap", snapLen, pcapSample),
+                            "Cannot create " << pcapPrefix << "-sta.pcap");
+        staCapture.Watch(staDevice.Get(0));
+    }
 
     Simulator::Stop(Seconds(duration + 1));
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    anim.Close();
+    apCapture.Close();
+    staCapture.Close();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    uint64_t events = Simulator::GetEventCount();
 
     // Statistics
     monitor->CheckForLostPackets();
@@ -166,7 +231,10 @@ int main(int argc, char *argv[])
     std::cout << "  Packets RX:      " << totalRxPackets << "\n";
     std::cout << "  Packets Lost:    " << totalLostPackets << "\n";
     std::cout << "  PDR:             " << pdr << " %\n";
-    std::cout << "  PLR:             " << plr << " %\n\n";
+    std::cout << "  PLR:             " << plr << " %\n";
+    std::cout << "  Events:          " << events << " in " << wall << " s ("
+              << (wall > 0 ? events / wall : 0) << " events/s, cacheLoss=" << cacheLoss
+              << ")\n\n";
 
     // Save to file
     std::string filename = "distance-" + std::to_string(channelWidth) + "mhz.dat";
@@ -175,7 +243,32 @@ int main(int argc, char *argv[])
     outFile.close();
 
     std::cout << "Data saved to: " << filename << "\n";
-    std::cout << "NetAnim file: " << animFile << "\n";
+    if (animation)
+    {
+        std::cout << "NetAnim file: " << anim.GetFilename() << " (" << anim.GetPackets()
+                  << " packets)\n";
+    }
+    if (pcap == "sampled")
+    {
+        std::cout << "Captured frames: " << apCapture.GetWritten() << "/" << apCapture.GetFrames()
+                  << " (AP), " << staCapture.GetWritten() << "/" << staCapture.GetFrames()
+                  << " (STA), disk stalls: " << apCapture.GetStalls() + staCapture.GetStalls()
+                  << "\n";
+    }
+    if (pcap != "off")
+    {
+        std::cout << "PCAP files: " << pcapPrefix << "*.pcap\n";
+    }
+    if (profile)
+    {
+        std::cout << "\n";
+        EventProfile::Report(std::cout);
+        if (EventProfile::WriteFolded(profileFile, "question5-2"))
+        {
+            std::cout << "Folded stacks: " << profileFile << " (flamegraph.pl " << profileFile
+                      << " > profile.svg)\n";
+        }
+    }
 
     Simulator::Destroy();
     return 0;
@@ -0,0 +1,175 @@
+/*
+ * Asynchronous file writer over a single-producer ring buffer.
+ *
+ * Write() copies into the ring and returns; a background thread drains
+ * the ring to disk in large contiguous writes. The producer only waits
+ * when the ring is full (counted in GetStalls()), so a slow disk shows up
+ * as stalls instead of as per-record I/O on the caller's thread.
+ */
+
+#ifndef RING_WRITER_H
+#define RING_WRITER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RingFileWriter
+{
+  public:
+    RingFileWriter() = default;
+    RingFileWriter(const RingFileWriter&) = delete;
+    RingFileWriter& operator=(const RingFileWriter&) = delete;
+
+    ~RingFileWriter()
+    {
+        Close();
+    }
+
+    /// Create path with a ring of capacity bytes (rounded up to a power of two).
+    bool Open(const std::string& path, size_t capacity = size_t(8) << 20)
+    {
+        Close();
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        size_t size = 4096;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        m_ring.assign(size, 0);
+        m_mask = size - 1;
+        m_head.store(0);
+        m_tail.store(0);
+        m_stalls = 0;
+        m_stop = false;
+        m_thread = std::thread(&RingFileWriter::Loop, this);
+        return true;
+    }
+
+    bool IsOpen() const
+    {
+        return m_file != nullptr;
+    }
+
+    /// Queue size bytes; nothing is written unless the file is open.
+    void Write(const void* data, size_t size)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        const char* p = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const uint64_t head = m_head.load(std::memory_order_relaxed);
+            size_t room = m_ring.size() - (head - m_tail.load(std::memory_order_acquire));
+            if (room == 0)
+            {
+                Stall();
+                continue;
+            }
+            const size_t n = std::min(size, room);
+            const size_t at = head & m_mask;
+            const size_t first = std::min(n, m_ring.size() - at);
+            std::memcpy(&m_ring[at], p, first);
+            std::memcpy(&m_ring[0], p + first, n - first);
+            m_head.store(head + n, std::memory_order_release);
+            if (head + n - m_tail.load(std::memory_order_relaxed) >= m_ring.size() / 4)
+            {
+                m_dataReady.notify_one();
+            }
+            p += n;
+            size -= n;
+        }
+    }
+
+    /// Drain the ring and close the file.
+    void Close()
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_dataReady.notify_one();
+        m_thread.join();
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_ring.clear();
+        m_ring.shrink_to_fit();
+    }
+
+    /// Times Write() had to wait for the disk.
+    uint64_t GetStalls() const
+    {
+        return m_stalls;
+    }
+
+  private:
+    void Stall()
+    {
+        m_stalls++;
+        m_dataReady.notify_one();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_spaceFreed.wait_for(lock, std::chrono::milliseconds(1), [this] {
+            return m_head.load() - m_tail.load() < m_ring.size();
+        });
+    }
+
+    void Loop()
+    {
+        while (true)
+        {
+            const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            const uint64_t pending = m_head.load(std::memory_order_acquire) - tail;
+            if (pending == 0)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_stop && m_head.load() == tail)
+                {
+                    return;
+                }
+                // Timed, so a wakeup missed by the lock-free producer only
+                // delays the drain.
+                m_dataReady.wait_for(lock, std::chrono::milliseconds(5), [this, tail] {
+                    return m_stop || m_head.load() - tail >= m_ring.size() / 4;
+                });
+                continue;
+            }
+            const size_t at = tail & m_mask;
+            const size_t n = std::min<uint64_t>(pending, m_ring.size() - at);
+            std::fwrite(&m_ring[at], 1, n, m_file);
+            m_tail.store(tail + n, std::memory_order_release);
+            m_spaceFreed.notify_one();
+        }
+    }
+
+    std::FILE* m_file = nullptr;
+    std::vector<char> m_ring;
+    size_t m_mask = 0;
+    std::atomic<uint64_t> m_head{0}; //!< bytes written by the producer
+    std::atomic<uint64_t> m_tail{0}; //!< bytes written to the file
+    uint64_t m_stalls = 0;
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_dataReady;
+    std::condition_variable m_spaceFreed;
+    std::thread m_thread;
+};
+
+#endif /* RING_WRITER_H */
@@ -0,0 +1,230 @@
+/*
+ * Uniform-grid spatial index for 2D node positions.
+ *
+ * Cells are at least as wide as the query radius, so every neighbor of a
+ * point lies in the 3x3 block of cells around it. Points are stored cell by
+ * cell (counting sort, row-major), so the three cells of one block row are
+ * a single contiguous run that the kernel of distance-kernel.h scans.
+ */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "distance-kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class SpatialGrid
+{
+  public:
+    /**
+     * Index n points for queries of radius up to cellSize.
+     */
+    void Build(const double* x, const double* y, uint32_t n, double cellSize)
+    {
+        m_x.assign(n, 0.0);
+        m_y.assign(n, 0.0);
+        m_id.assign(n, 0);
+        m_minX = 0;
+        m_minY = 0;
+        m_nx = 1;
+        m_ny = 1;
+        if (n == 0)
+        {
+            m_cellStart.assign(2, 0);
+            return;
+        }
+
+        double maxX = x[0];
+        double maxY = y[0];
+        m_minX = x[0];
+        m_minY = y[0];
+        for (uint32_t i = 1; i < n; i++)
+        {
+            m_minX = std::min(m_minX, x[i]);
+            m_minY = std::min(m_minY, y[i]);
+            maxX = std::max(maxX, x[i]);
+            maxY = std::max(maxY, y[i]);
+        }
+
+        // Widen the cell slightly so rounding in the cell computation can
+        // never put two points closer than the radius two cells apart, and
+        // keep the cell count proportional to n on sparse, wide areas.
+        m_cell = std::max(cellSize, 1e-9) * (1.0 + 1e-9);
+        const double maxCells = 4.0 * n + 1024.0;
+        while (((maxX - m_minX) / m_cell + 1) * ((maxY - m_minY) / m_cell + 1) > maxCells)
+        {
+            m_cell *= 2;
+        }
+        m_invCell = 1.0 / m_cell;
+        m_nx = static_cast<int32_t>((maxX - m_minX) * m_invCell) + 1;
+        m_ny = static_cast<int32_t>((maxY - m_minY) * m_invCell) + 1;
+
+        std::vector<uint32_t> cellOf(n);
+        m_cellStart.assign(static_cast<size_t>(m_nx) * m_ny + 1, 0);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            cellOf[i] = Cell(x[i], y[i]);
+            m_cellStart[cellOf[i] + 1]++;
+        }
+        for (size_t c = 1; c < m_cellStart.size(); c++)
+        {
+            m_cellStart[c] += m_cellStart[c - 1];
+        }
+        std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t slot = fill[cellOf[i]]++;
+            m_x[slot] = x[i];
+            m_y[slot] = y[i];
+            m_id[slot] = i;
+        }
+    }
+
+    /**
+     * Call f(begin, end) for each contiguous run of cell-ordered slots that
+     * may hold a point within one cell of (qx, qy).
+     */
+    template <typename F>
+    void ForEachCandidateRun(double qx, double qy, F f) const
+    {
+        int32_t cx = static_cast<int32_t>((qx - m_minX) * m_invCell);
+        int32_t cy = static_cast<int32_t>((qy - m_minY) * m_invCell);
+        int32_t x0 = std::max(cx - 1, 0);
+        int32_t x1 = std::min(cx + 1, m_nx - 1);
+        int32_t y0 = std::max(cy - 1, 0);
+        int32_t y1 = std::min(cy + 1, m_ny - 1);
+        if (x0 > x1)
+        {
+            return;
+        }
+        for (int32_t row = y0; row <= y1; row++)
+        {
+            size_t base = static_cast<size_t>(row) * m_nx;
+            uint32_t begin = m_cellStart[base + x0];
+            uint32_t end = m_cellStart[base + x1 + 1];
+            if (begin < end)
+            {
+                f(begin, end);
+            }
+        }
+    }
+
+    /**
+     * Number of indexed points within radius of (qx, qy), the query point
+     * itself included when it is indexed. radius must not exceed the cell
+     * size given to Build().
+     */
+    uint32_t CountWithin(double qx, double qy, double radius) const
+    {
+        const double r2 = radius * radius;
+        const CountWithinFn kernel = DistanceKernel();
+        uint32_t count = 0;
+        ForEachCandidateRun(qx, qy, [&](uint32_t begin, uint32_t end) {
+            count += kernel(&m_x[begin], &m_y[begin], end - begin, qx, qy, r2);
+        });
+        return count;
+    }
+
+    /**
+     * Call f(k) for every slot k other than `slot` whose point lies within
+     * sqrt(r2) of the point stored in `slot`.
+     */
+    template <typename F>
+    void ForEachWithin(uint32_t slot, double r2, F f) const
+    {
+        const double qx = m_x[slot];
+        const double qy = m_y[slot];
+        ForEachCandidateRun(qx, qy, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t k = begin; k < end; k++)
+            {
+                double dy = m_y[k] - qy;
+                double dx = m_x[k] - qx;
+                if (dy * dy + dx * dx <= r2 && k != slot)
+                {
+                    f(k);
+                }
+            }
+        });
+    }
+
+    /**
+     * Bin the indexed points around (qx, qy) by the smallest radius that
+     * covers them: bins[k] is incremented for r2[k-1] < d^2 <= r2[k]. r2 holds
+     * nr squared radii in ascending order, the largest not exceeding the cell
+     * size; points beyond it are ignored.
+     */
+    void BinWithin(double qx, double qy, const double* r2, uint32_t nr, uint32_t* bins) const
+    {
+        const double* r2End = r2 + nr;
+        ForEachCandidateRun(qx, qy, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t k = begin; k < end; k++)
+            {
+                double dy = m_y[k] - qy;
+                double dx = m_x[k] - qx;
+                double d2 = dy * dy + dx * dx;
+                const double* bin = std::lower_bound(r2, r2End, d2);
+                if (bin != r2End)
+                {
+                    bins[bin - r2]++;
+                }
+            }
+        });
+    }
+
+    /// Number of cells; the slots of cell c are [CellBegin(c), CellBegin(c + 1)).
+    uint32_t GetCellCount() const
+    {
+        return static_cast<uint32_t>(m_cellStart.size() - 1);
+    }
+
+    uint32_t CellBegin(uint32_t c) const
+    {
+        return m_cellStart[c];
+    }
+
+    uint32_t GetN() const
+    {
+        return static_cast<uint32_t>(m_id.size());
+    }
+
+    /// Coordinates and original index of the point stored in a slot.
+    double GetX(uint32_t slot) const
+    {
+        return m_x[slot];
+    }
+
+    double GetY(uint32_t slot) const
+    {
+        return m_y[slot];
+    }
+
+    uint32_t GetId(uint32_t slot) const
+    {
+        return m_id[slot];
+    }
+
+  private:
+    uint32_t Cell(double x, double y) const
+    {
+        int32_t cx = std::min(static_cast<int32_t>((x - m_minX) * m_invCell), m_nx - 1);
+        int32_t cy = std::min(static_cast<int32_t>((y - m_minY) * m_invCell), m_ny - 1);
+        return static_cast<uint32_t>(cy) * m_nx + cx;
+    }
+
+    double m_minX = 0;
+    double m_minY = 0;
+    double m_cell = 1;
+    double m_invCell = 1;
+    int32_t m_nx = 1;
+    int32_t m_ny = 1;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<uint32_t> m_id;
+    std::vector<uint32_t> m_cellStart;
+};
+
+#endif /* SPATIAL_GRID_H */
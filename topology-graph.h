@@ -0,0 +1,293 @@
+/*
+ * Unit-disk connectivity graph of a topology and the metrics used to screen
+ * a (topology, txrange) pair before simulating it: connected components,
+ * degree histogram and an approximate hop diameter.
+ */
+
+#ifndef TOPOLOGY_GRAPH_H
+#define TOPOLOGY_GRAPH_H
+
+#include "neighbor-engine.h"
+#include "spatial-grid.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compressed sparse row adjacency: the neighbors of node i are
+ * adj[offset[i]] .. adj[offset[i + 1] - 1], sorted by id.
+ */
+struct CsrGraph
+{
+    std::vector<uint64_t> offset;
+    std::vector<uint32_t> adj;
+
+    uint32_t GetN() const
+    {
+        return offset.empty() ? 0 : static_cast<uint32_t>(offset.size() - 1);
+    }
+
+    uint32_t Degree(uint32_t i) const
+    {
+        return static_cast<uint32_t>(offset[i + 1] - offset[i]);
+    }
+
+    bool HasEdge(uint32_t i, uint32_t j) const
+    {
+        return std::binary_search(adj.begin() + offset[i], adj.begin() + offset[i + 1], j);
+    }
+};
+
+/**
+ * Link every pair of nodes at most radius apart. The grid must have been
+ * built with a cell size of at least radius.
+ */
+inline CsrGraph
+BuildUnitDiskGraph(const SpatialGrid& grid, double radius, uint32_t threads)
+{
+    const uint32_t n = grid.GetN();
+    const double r2 = radius * radius;
+    CsrGraph g;
+    g.offset.assign(static_cast<size_t>(n) + 1, 0);
+    ForEachCellChunk(grid, threads, [&](uint32_t, uint32_t cellBegin, uint32_t cellEnd) {
+        for (uint32_t s = grid.CellBegin(cellBegin); s < grid.CellBegin(cellEnd); s++)
+        {
+            uint64_t degree = 0;
+            grid.ForEachWithin(s, r2, [&](uint32_t) { degree++; });
+            g.offset[grid.GetId(s) + 1] = degree;
+        }
+    });
+    for (uint32_t i = 0; i < n; i++)
+    {
+        g.offset[i + 1] += g.offset[i];
+    }
+    g.adj.resize(g.offset[n]);
+
+    // Each node owns its own slice of adj, so workers never overlap.
+    ForEachCellChunk(grid, threads, [&](uint32_t, uint32_t cellBegin, uint32_t cellEnd) {
+        for (uint32_t s = grid.CellBegin(cellBegin); s < grid.CellBegin(cellEnd); s++)
+        {
+            const uint32_t id = grid.GetId(s);
+            uint32_t* out = &g.adj[g.offset[id]];
+            grid.ForEachWithin(s, r2, [&](uint32_t k) { *out++ = grid.GetId(k); });
+            std::sort(&g.adj[g.offset[id]], out);
+        }
+    });
+    return g;
+}
+
+/// Disjoint sets with union by size and path halving.
+class UnionFind
+{
+  public:
+    explicit UnionFind(uint32_t n)
+        : m_parent(n),
+          m_size(n, 1)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            m_parent[i] = i;
+        }
+    }
+
+    uint32_t Find(uint32_t i)
+    {
+        while (m_parent[i] != i)
+        {
+            m_parent[i] = m_parent[m_parent[i]];
+            i = m_parent[i];
+        }
+        return i;
+    }
+
+    bool Union(uint32_t a, uint32_t b)
+    {
+        a = Find(a);
+        b = Find(b);
+        if (a == b)
+        {
+            return false;
+        }
+        if (m_size[a] < m_size[b])
+        {
+            std::swap(a, b);
+        }
+        m_parent[b] = a;
+        m_size[a] += m_size[b];
+        return true;
+    }
+
+    uint32_t Size(uint32_t i)
+    {
+        return m_size[Find(i)];
+    }
+
+  private:
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_size;
+};
+
+struct ConnectivityReport
+{
+    uint32_t nodes = 0;
+    uint64_t links = 0;
+    uint32_t components = 0;
+    uint32_t largest = 0;              //!< nodes in the largest component
+    uint32_t isolated = 0;             //!< nodes without any neighbor
+    std::vector<uint64_t> degreeHist;  //!< degreeHist[d]: nodes of degree d
+    uint32_t hopDiameter = 0;          //!< lower bound, largest component
+
+    bool Connected() const
+    {
+        return components <= 1;
+    }
+};
+
+/**
+ * Eccentricity lower bounds from up to 64 sources at once: one bit per
+ * source in the seen/frontier masks, so one pass over the frontier nodes
+ * advances every BFS by one hop. Returns the largest eccentricity found
+ * and stores the nodes reached last in `farthest`.
+ */
+inline uint32_t
+MultiSourceBfs(const CsrGraph& g,
+               const std::vector<uint32_t>& sources,
+               std::vector<uint32_t>& farthest)
+{
+    const uint32_t n = g.GetN();
+    std::vector<uint64_t> seen(n, 0);
+    std::vector<uint64_t> frontier(n, 0);
+    std::vector<uint64_t> next(n, 0);
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> reached;
+    for (size_t b = 0; b < sources.size() && b < 64; b++)
+    {
+        if (!frontier[sources[b]])
+        {
+            active.push_back(sources[b]);
+        }
+        seen[sources[b]] |= uint64_t(1) << b;
+        frontier[sources[b]] |= uint64_t(1) << b;
+    }
+
+    // Top-down: only nodes carrying a frontier bit push to their neighbors.
+    uint32_t level = 0;
+    farthest = active;
+    while (!active.empty())
+    {
+        reached.clear();
+        for (uint32_t v : active)
+        {
+            const uint64_t bits = frontier[v];
+            for (uint64_t e = g.offset[v]; e < g.offset[v + 1]; e++)
+            {
+                const uint32_t u = g.adj[e];
+                const uint64_t fresh = bits & ~seen[u] & ~next[u];
+                if (fresh)
+                {
+                    if (!next[u])
+                    {
+                        reached.push_back(u);
+                    }
+                    next[u] |= fresh;
+                }
+            }
+            frontier[v] = 0;
+        }
+        if (reached.empty())
+        {
+            break;
+        }
+        level++;
+        for (uint32_t u : reached)
+        {
+            seen[u] |= next[u];
+            frontier[u] = next[u];
+            next[u] = 0;
+        }
+        active.swap(reached);
+        farthest = active;
+    }
+    return level;
+}
+
+/**
+ * Components, degree histogram and approximate hop diameter of g. The
+ * diameter is the best lower bound of two multi-source sweeps over the
+ * largest component: up to 64 spread-out sources, then the nodes the
+ * first sweep reached last (the double-sweep heuristic, many ways at once).
+ */
+inline ConnectivityReport
+AnalyzeConnectivity(const CsrGraph& g)
+{
+    ConnectivityReport r;
+    const uint32_t n = g.GetN();
+    r.nodes = n;
+    r.links = g.adj.size() / 2;
+    if (n == 0)
+    {
+        return r;
+    }
+
+    UnionFind uf(n);
+    uint32_t components = n;
+    for (uint32_t v = 0; v < n; v++)
+    {
+        uint32_t d = g.Degree(v);
+        if (r.degreeHist.size() <= d)
+        {
+            r.degreeHist.resize(d + 1, 0);
+        }
+        r.degreeHist[d]++;
+        r.isolated += (d == 0);
+        for (uint64_t e = g.offset[v]; e < g.offset[v + 1]; e++)
+        {
+            if (g.adj[e] > v && uf.Union(v, g.adj[e]))
+            {
+                components--;
+            }
+        }
+    }
+    r.components = components;
+
+    uint32_t root = 0;
+    for (uint32_t v = 0; v < n; v++)
+    {
+        if (uf.Size(v) > r.largest)
+        {
+            r.largest = uf.Size(v);
+            root = uf.Find(v);
+        }
+    }
+
+    std::vector<uint32_t> members;
+    members.reserve(r.largest);
+    for (uint32_t v = 0; v < n; v++)
+    {
+        if (uf.Find(v) == root)
+        {
+            members.push_back(v);
+        }
+    }
+    // Spread-out sources rarely share a frontier, so a sweep costs about one
+    // BFS per source: cap them at roughly 1e8 edge visits per sweep.
+    const size_t width = std::clamp<size_t>(100000000 / std::max<size_t>(g.adj.size(), 1), 1, 64);
+    std::vector<uint32_t> sources;
+    const size_t step = std::max<size_t>(1, members.size() / width);
+    for (size_t m = 0; m < members.size() && sources.size() < width; m += step)
+    {
+        sources.push_back(members[m]);
+    }
+    std::vector<uint32_t> farthest;
+    r.hopDiameter = MultiSourceBfs(g, sources, farthest);
+    if (farthest.size() > width)
+    {
+        farthest.resize(width);
+    }
+    std::vector<uint32_t> unused;
+    r.hopDiameter = std::max(r.hopDiameter, MultiSourceBfs(g, farthest, unused));
+    return r;
+}
+
+#endif /* TOPOLOGY_GRAPH_H */
@@ -0,0 +1,436 @@
+/*
+ * Topology loader shared by number_of_neighbors and manet-28.
+ *
+ * Reads "id,x,y[,z]" rows (one node per line, as in manet100.csv) into a
+ * structure-of-arrays Topology of any size. The file is mapped once and
+ * parsed in place with std::from_chars, so there is no per-line string
+ * allocation and no fixed node limit.
+ *
+ * Topologies that are loaded again and again can be converted once (see
+ * topology_convert.cpp) to a binary columnar file: a fixed header followed
+ * by contiguous id and float32/float64 x, y (and optionally z) columns. It
+ * is memory-mapped and read in place, with no parsing at all.
+ */
+
+#ifndef TOPOLOGY_LOADER_H
+#define TOPOLOGY_LOADER_H
+
+#include "mapped-file.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct Topology
+{
+    std::vector<uint32_t> id;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z; //!< empty for planar topologies
+
+    size_t Size() const
+    {
+        return x.size();
+    }
+
+    void Clear()
+    {
+        id.clear();
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+
+    void Reserve(size_t n)
+    {
+        id.reserve(n);
+        x.reserve(n);
+        y.reserve(n);
+    }
+};
+
+/**
+ * Parse one comma-separated numeric field starting at p, leaving p after the
+ * separator (or at the end of line). Blanks around the value are allowed.
+ */
+template <typename T>
+inline bool
+CsvParseField(const char*& p, const char* eol, T& value)
+{
+    while (p < eol && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    auto res = std::from_chars(p, eol, value);
+    if (res.ec != std::errc())
+    {
+        return false;
+    }
+    p = res.ptr;
+    while (p < eol && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    if (p < eol)
+    {
+        if (*p != ',')
+        {
+            return false;
+        }
+        p++;
+    }
+    return true;
+}
+
+/**
+ * Return the end of the line starting at p (excluding "\r\n" / "\n"), and
+ * set next to the start of the following line.
+ */
+inline const char*
+CsvLineEnd(const char* p, const char* end, const char*& next)
+{
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    next = nl ? nl + 1 : end;
+    const char* eol = nl ? nl : end;
+    if (eol > p && eol[-1] == '\r')
+    {
+        eol--;
+    }
+    return eol;
+}
+
+/**
+ * Parse "id,x,y[,z]" rows from a buffer. Blank lines and a non-numeric
+ * header line are skipped; any other malformed row fails with its line
+ * number. Rows without z get 0 once any row has one.
+ */
+inline bool
+ParseTopologyCsv(const char* data, size_t size, Topology& topo, std::string* error = nullptr)
+{
+    topo.Clear();
+    const char* p = data;
+    const char* end = data + size;
+    topo.Reserve(static_cast<size_t>(std::count(p, end, '\n')) + 1);
+
+    uint64_t line = 0;
+    while (p < end)
+    {
+        const char* next;
+        const char* eol = CsvLineEnd(p, end, next);
+        line++;
+
+        const char* q = p;
+        while (q < eol && (*q == ' ' || *q == '\t'))
+        {
+            q++;
+        }
+        if (q < eol)
+        {
+            uint32_t id;
+            double x;
+            double y;
+            double z = 0;
+            const char* f = q;
+            bool hasZ = false;
+            bool ok = CsvParseField(f, eol, id) && CsvParseField(f, eol, x) &&
+                      CsvParseField(f, eol, y);
+            if (ok && f != eol)
+            {
+                hasZ = CsvParseField(f, eol, z);
+            }
+            if (!ok || f != eol)
+            {
+                bool header = (line == 1 && !(*q >= '0' && *q <= '9') && *q != '-');
+                if (!header)
+                {
+                    if (error)
+                    {
+                        *error = "malformed row at line " + std::to_string(line);
+                    }
+                    return false;
+                }
+            }
+            else
+            {
+                topo.id.push_back(id);
+                topo.x.push_back(x);
+                topo.y.push_back(y);
+                if (hasZ || !topo.z.empty())
+                {
+                    topo.z.resize(topo.x.size() - 1, 0.0);
+                    topo.z.push_back(z);
+                }
+            }
+        }
+        p = next;
+    }
+    return true;
+}
+
+/**
+ * Header of a binary topology file. All fields are little-endian; each
+ * column starts at a 64-byte aligned offset from the start of the file.
+ */
+struct TopologyFileHeader
+{
+    static constexpr char MAGIC[8] = {'M', 'A', 'N', 'E', 'T', 'T', 'O', 'P'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_FLOAT64 = 1; //!< x/y/z are double, else float
+    static constexpr uint32_t FLAG_HAS_Z = 2;   //!< a z column is present
+
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t idOffset;
+    uint64_t xOffset;
+    uint64_t yOffset;
+    uint64_t zOffset; //!< 0 without FLAG_HAS_Z
+    uint64_t reserved;
+};
+
+static_assert(sizeof(TopologyFileHeader) == 64, "binary topology header must stay 64 bytes");
+
+/**
+ * Read-only view of a mapped binary topology file.
+ */
+class TopologyView
+{
+  public:
+    /**
+     * Map path. Returns false if it cannot be read or is not a valid binary
+     * topology (CSV files included).
+     */
+    bool Open(const std::string& path, std::string* error = nullptr)
+    {
+        if (!m_file.Open(path))
+        {
+            return Fail(error, "cannot open " + path);
+        }
+        return Attach(m_file.Data(), m_file.Size(), error);
+    }
+
+    /// Validate a binary topology held in memory (kept by the caller).
+    bool Attach(const char* data, size_t size, std::string* error = nullptr)
+    {
+        m_data = data;
+        if (!IsBinaryTopology(data, size))
+        {
+            return Fail(error, "not a binary topology");
+        }
+        std::memcpy(&m_header, data, sizeof(m_header));
+        if (m_header.version != TopologyFileHeader::VERSION)
+        {
+            return Fail(error, "unsupported binary topology version");
+        }
+        const uint64_t elem = IsDouble() ? 8 : 4;
+        const uint64_t n = m_header.count;
+        bool ok = ColumnFits(m_header.idOffset, n * 4, size) &&
+                  ColumnFits(m_header.xOffset, n * elem, size) &&
+                  ColumnFits(m_header.yOffset, n * elem, size) &&
+                  (!HasZ() || ColumnFits(m_header.zOffset, n * elem, size));
+        if (!ok)
+        {
+            return Fail(error, "truncated binary topology");
+        }
+        return true;
+    }
+
+    static bool IsBinaryTopology(const char* data, size_t size)
+    {
+        return size >= sizeof(TopologyFileHeader) &&
+               std::memcmp(data, TopologyFileHeader::MAGIC, 8) == 0;
+    }
+
+    size_t Size() const
+    {
+        return m_header.count;
+    }
+
+    bool IsDouble() const
+    {
+        return m_header.flags & TopologyFileHeader::FLAG_FLOAT64;
+    }
+
+    bool HasZ() const
+    {
+        return m_header.flags & TopologyFileHeader::FLAG_HAS_Z;
+    }
+
+    uint32_t Id(size_t i) const
+    {
+        return Column<uint32_t>(m_header.idOffset)[i];
+    }
+
+    double X(size_t i) const
+    {
+        return Coord(m_header.xOffset, i);
+    }
+
+    double Y(size_t i) const
+    {
+        return Coord(m_header.yOffset, i);
+    }
+
+    double Z(size_t i) const
+    {
+        return HasZ() ? Coord(m_header.zOffset, i) : 0.0;
+    }
+
+    /// Direct column pointers; only valid for float64 files.
+    const double* XData() const
+    {
+        return Column<double>(m_header.xOffset);
+    }
+
+    const double* YData() const
+    {
+        return Column<double>(m_header.yOffset);
+    }
+
+    const uint32_t* IdData() const
+    {
+        return Column<uint32_t>(m_header.idOffset);
+    }
+
+  private:
+    template <typename T>
+    const T* Column(uint64_t offset) const
+    {
+        return reinterpret_cast<const T*>(m_data + offset);
+    }
+
+    double Coord(uint64_t offset, size_t i) const
+    {
+        return IsDouble() ? Column<double>(offset)[i] : Column<float>(offset)[i];
+    }
+
+    static bool ColumnFits(uint64_t offset, uint64_t bytes, size_t size)
+    {
+        return offset % 64 == 0 && offset >= sizeof(TopologyFileHeader) && offset <= size &&
+               bytes <= size - offset;
+    }
+
+    static bool Fail(std::string* error, const std::string& what)
+    {
+        if (error)
+        {
+            *error = what;
+        }
+        return false;
+    }
+
+    MappedFile m_file;
+    const char* m_data = nullptr;
+    TopologyFileHeader m_header{};
+};
+
+/**
+ * Write topo as a binary topology file with float64 or float32 columns.
+ * The z column is only stored when topo has one.
+ */
+inline bool
+WriteBinaryTopology(const std::string& path, const Topology& topo, bool float64)
+{
+    const bool z = !topo.z.empty();
+    auto align = [](uint64_t v) { return (v + 63) / 64 * 64; };
+    const uint64_t n = topo.Size();
+    const uint64_t elem = float64 ? 8 : 4;
+    TopologyFileHeader h{};
+    std::memcpy(h.magic, TopologyFileHeader::MAGIC, 8);
+    h.version = TopologyFileHeader::VERSION;
+    h.flags = (float64 ? TopologyFileHeader::FLAG_FLOAT64 : 0) |
+              (z ? TopologyFileHeader::FLAG_HAS_Z : 0);
+    h.count = n;
+    h.idOffset = sizeof(h);
+    h.xOffset = align(h.idOffset + n * 4);
+    h.yOffset = align(h.xOffset + n * elem);
+    h.zOffset = z ? align(h.yOffset + n * elem) : 0;
+    const uint64_t end = (z ? h.zOffset : h.yOffset) + n * elem;
+
+    std::vector<char> out(end, 0);
+    std::memcpy(out.data(), &h, sizeof(h));
+    std::memcpy(out.data() + h.idOffset, topo.id.data(), n * 4);
+    auto column = [&](uint64_t offset, const std::vector<double>& v) {
+        if (float64)
+        {
+            std::memcpy(out.data() + offset, v.data(), n * 8);
+            return;
+        }
+        for (uint64_t i = 0; i < n; i++)
+        {
+            float f = static_cast<float>(v[i]);
+            std::memcpy(out.data() + offset + i * 4, &f, 4);
+        }
+    };
+    column(h.xOffset, topo.x);
+    column(h.yOffset, topo.y);
+    if (z)
+    {
+        column(h.zOffset, topo.z);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+/**
+ * Load a topology file into topo, CSV or binary (detected from the magic).
+ * Returns false and fills error when the file cannot be read or parsed.
+ */
+inline bool
+LoadTopology(const std::string& path, Topology& topo, std::string* error = nullptr)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        if (error)
+        {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+    if (TopologyView::IsBinaryTopology(file.Data(), file.Size()))
+    {
+        TopologyView view;
+        if (!view.Attach(file.Data(), file.Size(), error))
+        {
+            return false;
+        }
+        const size_t n = view.Size();
+        topo.Clear();
+        topo.id.assign(view.IdData(), view.IdData() + n);
+        if (view.IsDouble())
+        {
+            topo.x.assign(view.XData(), view.XData() + n);
+            topo.y.assign(view.YData(), view.YData() + n);
+        }
+        else
+        {
+            topo.x.resize(n);
+            topo.y.resize(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                topo.x[i] = view.X(i);
+                topo.y[i] = view.Y(i);
+            }
+        }
+        if (view.HasZ())
+        {
+            topo.z.resize(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                topo.z[i] = view.Z(i);
+            }
+        }
+        return true;
+    }
+    return ParseTopologyCsv(file.Data(), file.Size(), topo, error);
+}
+
+#endif /* TOPOLOGY_LOADER_H */
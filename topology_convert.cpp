@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+
+#include "topology-loader.h"
+
+using namespace std;
+
+// Convert an "id,x,y[,z]" CSV topology to the binary columnar format that
+// manet-28 and number_of_neighbors map without parsing:
+//   topology_convert manet100.csv manet100.top [--float32]
+// Coordinates are stored as float64 unless --float32 is given.
+int main (int argc, char **argv)
+{
+  std::string input, output;
+  bool float64 = true;
+  for (int a = 1; a < argc; a++)
+  {
+	std::string arg = argv[a];
+	if (arg == "--float32")
+	{
+		float64 = false;
+	}
+	else if (arg == "--float64")
+	{
+		float64 = true;
+	}
+	else if (input.empty())
+	{
+		input = arg;
+	}
+	else if (output.empty())
+	{
+		output = arg;
+	}
+	else
+	{
+		cerr << "Unexpected argument " << arg << endl;
+		return 1;
+	}
+  }
+  if (input.empty() || output.empty())
+  {
+	cerr << "Usage: " << argv[0] << " input.csv output.top [--float32]" << endl;
+	return 1;
+  }
+
+  Topology topo;
+  std::string error;
+  if (!LoadTopology(input, topo, &error))
+  {
+	cerr << "Error in csv file: " << error << endl;
+	return 1;
+  }
+  if (!WriteBinaryTopology(output, topo, float64))
+  {
+	cerr << "Cannot write " << output << endl;
+	return 1;
+  }
+  cout << "Wrote " << topo.Size() << " nodes (" << (float64 ? "float64" : "float32")
+	   << (topo.z.empty() ? "" : ", with z") << ") to " << output << "." << endl;
+  return 0;
+}
@@ -0,0 +1,557 @@
+#include <iostream>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped-file.h"
+
+using namespace std;
+
+// Native version of TopologyAnalyzer.analyze_trace_file_udp_only
+// (analyse_performance.py) for ns-3 ASCII traces:
+//   trace_analyzer tracemetrics.tr
+// prints throughput, delay, pdr, lost, tx_packets, rx_packets and duration
+// as "key=value" lines, with the same values as the Python loop (floats in
+// shortest round-trip form). Every step follows the Python semantics: lines
+// end at \n, \r or \r\n; the 'udp' and 'dst=9' tests ignore case; fields are
+// split on any whitespace str.split() knows; the time is parsed like
+// float(); uids are compared as digit strings; the mean delay is numpy's
+// pairwise sum divided by the count. Only ASCII digits count as \d.
+
+// Byte length of the whitespace character at p (str.isspace), 0 if none.
+static inline size_t SpaceLength (const unsigned char *p, const unsigned char *end)
+{
+  const unsigned char c = *p;
+  if (c == ' ' || (c >= 0x09 && c <= 0x0d) || (c >= 0x1c && c <= 0x1f))
+  {
+	return 1;
+  }
+  if (c < 0xc2)
+  {
+	return 0;
+  }
+  if (c == 0xc2 && end - p >= 2)
+  {
+	return (p[1] == 0x85 || p[1] == 0xa0) ? 2 : 0; // U+0085, U+00A0
+  }
+  if (end - p < 3)
+  {
+	return 0;
+  }
+  if (c == 0xe1)
+  {
+	return (p[1] == 0x9a && p[2] == 0x80) ? 3 : 0; // U+1680
+  }
+  if (c == 0xe2 && p[1] == 0x80)
+  {
+	// U+2000..U+200A, U+2028, U+2029, U+202F
+	return (p[2] <= 0x8a && p[2] >= 0x80) || p[2] == 0xa8 || p[2] == 0xa9 || p[2] == 0xaf ? 3 : 0;
+  }
+  if (c == 0xe2 && p[1] == 0x81)
+  {
+	return p[2] == 0x9f ? 3 : 0; // U+205F
+  }
+  if (c == 0xe3)
+  {
+	return (p[1] == 0x80 && p[2] == 0x80) ? 3 : 0; // U+3000
+  }
+  return 0;
+}
+
+static inline char Lower (char c)
+{
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// a equals word (lower case), ignoring the case of a.
+static bool EqualsNoCase (std::string_view a, std::string_view word)
+{
+  if (a.size() != word.size())
+  {
+	return false;
+  }
+  for (size_t i = 0; i < a.size(); i++)
+  {
+	if (Lower(a[i]) != word[i])
+	{
+		return false;
+	}
+  }
+  return true;
+}
+
+// needle (lower case, starting with a letter) occurs in line, ignoring
+// the case of line. Candidates are found with memchr on both cases of the
+// first letter.
+static bool ContainsNoCase (std::string_view line, std::string_view needle)
+{
+  if (line.size() < needle.size())
+  {
+	return false;
+  }
+  const char first[2] = {needle[0], static_cast<char>(needle[0] - ('a' - 'A'))};
+  for (char c : first)
+  {
+	const char *p = line.data();
+	const char *last = line.data() + line.size() - needle.size();
+	while (p <= last && (p = static_cast<const char *>(std::memchr(p, c, last - p + 1))) != nullptr)
+	{
+		if (EqualsNoCase(std::string_view(p, needle.size()), needle))
+		{
+			return true;
+		}
+		p++;
+	}
+  }
+  return false;
+}
+
+// ':9 >' in line or ':9>' in line or 'dst=9' in line.lower()
+static bool PortNine (std::string_view line)
+{
+  for (size_t at = line.find(":9"); at != std::string_view::npos; at = line.find(":9", at + 1))
+  {
+	std::string_view after = line.substr(at + 2);
+	if (after.substr(0, 1) == ">" || after.substr(0, 2) == " >")
+	{
+		return true;
+	}
+  }
+  for (size_t at = line.find("=9"); at != std::string_view::npos; at = line.find("=9", at + 1))
+  {
+	if (at >= 3 && EqualsNoCase(line.substr(at - 3, 3), "dst"))
+	{
+		return true;
+	}
+  }
+  return false;
+}
+
+// re.search(prefix + r'[:\s]+(\d+)', line).group(1), empty if no match.
+static std::string_view SearchNumber (std::string_view line, std::string_view prefix)
+{
+  const unsigned char *end = reinterpret_cast<const unsigned char *>(line.data() + line.size());
+  for (size_t at = line.find(prefix); at != std::string_view::npos; at = line.find(prefix, at + 1))
+  {
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(line.data() + at + prefix.size());
+	const unsigned char *sep = p;
+	while (p < end)
+	{
+		size_t n = *p == ':' ? 1 : SpaceLength(p, end);
+		if (n == 0)
+		{
+			break;
+		}
+		p += n;
+	}
+	const unsigned char *digits = p;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		p++;
+	}
+	if (digits > sep && p > digits)
+	{
+		return std::string_view(reinterpret_cast<const char *>(digits), p - digits);
+	}
+  }
+  return std::string_view();
+}
+
+// float(token): decimal with optional sign, '_' between digits, exponent,
+// or inf/infinity/nan in any case. The grammar is checked first; only
+// tokens with '_' or a leading '+' are copied before conversion.
+static bool ParsePythonFloat (std::string_view token, double &value)
+{
+  const size_t size = token.size();
+  size_t i = 0;
+  bool copy = false;
+  if (i < size && (token[i] == '+' || token[i] == '-'))
+  {
+	copy = token[i] == '+';
+	i++;
+  }
+  std::string_view rest = token.substr(i);
+  if (EqualsNoCase(rest, "inf") || EqualsNoCase(rest, "infinity") || EqualsNoCase(rest, "nan"))
+  {
+	value = rest[0] == 'n' || rest[0] == 'N' ? std::numeric_limits<double>::quiet_NaN()
+	                                         : std::numeric_limits<double>::infinity();
+	value = token[0] == '-' ? -value : value;
+	return true;
+  }
+  // digits: [0-9](_?[0-9])*
+  auto digits = [&](size_t &k) {
+	if (k >= size || token[k] < '0' || token[k] > '9')
+	{
+		return false;
+	}
+	k++;
+	while (k < size)
+	{
+		if (token[k] >= '0' && token[k] <= '9')
+		{
+			k++;
+		}
+		else if (token[k] == '_' && k + 1 < size && token[k + 1] >= '0' && token[k + 1] <= '9')
+		{
+			copy = true;
+			k++;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return true;
+  };
+  bool integer = digits(i);
+  bool fraction = false;
+  if (i < size && token[i] == '.')
+  {
+	i++;
+	fraction = digits(i);
+  }
+  if (!integer && !fraction)
+  {
+	return false;
+  }
+  if (i < size && (token[i] == 'e' || token[i] == 'E'))
+  {
+	i++;
+	if (i < size && (token[i] == '+' || token[i] == '-'))
+	{
+		i++;
+	}
+	if (!digits(i))
+	{
+		return false;
+	}
+  }
+  if (i != size)
+  {
+	return false;
+  }
+  if (!copy)
+  {
+	std::from_chars(token.data(), token.data() + size, value);
+	return true;
+  }
+  static std::string clean;
+  clean.clear();
+  for (char c : token.substr(token[0] == '+' ? 1 : 0))
+  {
+	if (c != '_')
+	{
+		clean += c;
+	}
+  }
+  std::from_chars(clean.data(), clean.data() + clean.size(), value);
+  return true;
+}
+
+// uid digit string -> time of its latest '+', open addressing. Strings of
+// up to 19 digits are keyed by (value, length), so "007" and "7" differ
+// without touching the trace again; longer ones point into it.
+class UidTable
+{
+public:
+  UidTable ()
+  {
+	m_slots.resize(1 << 16);
+  }
+
+  void Set (std::string_view uid, double time)
+  {
+	if (2 * (m_used + 1) > m_slots.size())
+	{
+		Grow();
+	}
+	Slot key = Key(uid);
+	Slot &s = Find(key);
+	if (s.length == 0)
+	{
+		s = key;
+		m_used++;
+	}
+	s.time = time;
+  }
+
+  bool Get (std::string_view uid, double &time) const
+  {
+	const Slot &s = const_cast<UidTable *>(this)->Find(Key(uid));
+	if (s.length == 0)
+	{
+		return false;
+	}
+	time = s.time;
+	return true;
+  }
+
+private:
+  struct Slot
+  {
+	uint64_t value = 0; //!< the digits, or their hash beyond 19
+	const char *data = nullptr;
+	uint32_t length = 0; //!< 0 = empty
+	double time = 0;
+  };
+
+  static Slot Key (std::string_view uid)
+  {
+	Slot key;
+	key.data = uid.data();
+	key.length = static_cast<uint32_t>(uid.size());
+	if (uid.size() <= 19)
+	{
+		for (char c : uid)
+		{
+			key.value = key.value * 10 + (c - '0');
+		}
+	}
+	else
+	{
+		key.value = 1469598103934665603ULL;
+		for (char c : uid)
+		{
+			key.value = (key.value ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+		}
+	}
+	return key;
+  }
+
+  static uint64_t Hash (const Slot &key)
+  {
+	uint64_t h = key.value + key.length * 0x9e3779b97f4a7c15ULL;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	return h ^ (h >> 31);
+  }
+
+  static bool Same (const Slot &a, const Slot &b)
+  {
+	return a.value == b.value && a.length == b.length &&
+	       (a.length <= 19 || std::memcmp(a.data, b.data, a.length) == 0);
+  }
+
+  Slot &Find (const Slot &key)
+  {
+	const size_t mask = m_slots.size() - 1;
+	size_t i = Hash(key) & mask;
+	while (m_slots[i].length != 0 && !Same(m_slots[i], key))
+	{
+		i = (i + 1) & mask;
+	}
+	return m_slots[i];
+  }
+
+  void Grow ()
+  {
+	std::vector<Slot> old(m_slots.size() * 2);
+	old.swap(m_slots);
+	for (const Slot &s : old)
+	{
+		if (s.length != 0)
+		{
+			Find(s) = s;
+		}
+	}
+  }
+
+  std::vector<Slot> m_slots;
+  size_t m_used = 0;
+};
+
+// numpy's pairwise summation (pairwise_sum_DOUBLE), as used by np.mean.
+static double PairwiseSum (const double *a, size_t n)
+{
+  if (n < 8)
+  {
+	double res = 0.;
+	for (size_t i = 0; i < n; i++)
+	{
+		res += a[i];
+	}
+	return res;
+  }
+  if (n <= 128)
+  {
+	double r[8];
+	for (int j = 0; j < 8; j++)
+	{
+		r[j] = a[j];
+	}
+	size_t i;
+	for (i = 8; i < n - (n % 8); i += 8)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			r[j] += a[i + j];
+		}
+	}
+	double res = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+	for (; i < n; i++)
+	{
+		res += a[i];
+	}
+	return res;
+  }
+  size_t n2 = n / 2;
+  n2 -= n2 % 8;
+  return PairwiseSum(a, n2) + PairwiseSum(a + n2, n - n2);
+}
+
+static std::string Repr (double v)
+{
+  char buf[64];
+  auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  return std::string(buf, res.ptr);
+}
+
+// What analyze_trace_file_udp_only accumulates over the lines it keeps.
+struct TraceTotals
+{
+  UidTable sent;
+  std::vector<double> delays;
+  uint64_t txCount = 0;
+  uint64_t rxCount = 0;
+  uint64_t rxBytes = 0;
+  double startTime = std::numeric_limits<double>::infinity();
+  double endTime = 0;
+
+  void Add (std::string_view line)
+  {
+	if (!PortNine(line) || !ContainsNoCase(line, "udp"))
+	{
+		return;
+	}
+
+	// parts[0] and parts[1] of line.split()
+	std::string_view parts[2];
+	size_t nparts = 0;
+	const unsigned char *q = reinterpret_cast<const unsigned char *>(line.data());
+	const unsigned char *qend = q + line.size();
+	while (q < qend && nparts < 2)
+	{
+		size_t n;
+		while (q < qend && (n = SpaceLength(q, qend)) > 0)
+		{
+			q += n;
+		}
+		if (q == qend)
+		{
+			break;
+		}
+		const unsigned char *start = q;
+		while (q < qend && SpaceLength(q, qend) == 0)
+		{
+			q++;
+		}
+		parts[nparts++] = std::string_view(reinterpret_cast<const char *>(start), q - start);
+	}
+	double time;
+	if (nparts < 2 || !ParsePythonFloat(parts[1], time))
+	{
+		return;
+	}
+	startTime = std::min(startTime, time);
+	endTime = std::max(endTime, time);
+
+	std::string_view size = SearchNumber(line, "length");
+	uint64_t packetSize = 1024;
+	if (!size.empty())
+	{
+		std::from_chars(size.data(), size.data() + size.size(), packetSize);
+	}
+	std::string_view uid = SearchNumber(line, "ns3::Packet");
+
+	if (parts[0] == "+")
+	{
+		txCount++;
+		if (!uid.empty())
+		{
+			sent.Set(uid, time);
+		}
+	}
+	else if (parts[0] == "r")
+	{
+		rxCount++;
+		rxBytes += packetSize;
+		double txTime;
+		if (!uid.empty() && sent.Get(uid, txTime))
+		{
+			double delay = (time - txTime) * 1000;
+			if (0 < delay && delay < 1000)
+			{
+				delays.push_back(delay);
+			}
+		}
+	}
+  }
+};
+
+int main (int argc, char **argv)
+{
+  if (argc != 2)
+  {
+	cerr << "Usage: " << argv[0] << " tracemetrics.tr" << endl;
+	return 1;
+  }
+  MappedFile file;
+  if (!file.Open(argv[1]))
+  {
+	cerr << argv[1] << " not found" << endl;
+	return 1;
+  }
+
+  // A kept line holds ":9" (':9 >', ':9>') or "=9" ('dst=9'): find those
+  // with memchr over the whole trace and only split out the lines around
+  // them, so the rest of the file is never looked at byte by byte.
+  const char *data = file.Data();
+  const char *end = data + file.Size();
+  TraceTotals totals;
+  const char *from = data; // start of the first line not looked at yet
+  const char *nine = data;
+  while ((nine = static_cast<const char *>(std::memchr(nine, '9', end - nine))) != nullptr)
+  {
+	if (nine == from || (nine[-1] != ':' && nine[-1] != '='))
+	{
+		nine++;
+		continue;
+	}
+	const char *start = nine;
+	while (start > from && start[-1] != '\n' && start[-1] != '\r')
+	{
+		start--;
+	}
+	const char *stop = static_cast<const char *>(std::memchr(nine, '\n', end - nine));
+	stop = stop ? stop : end;
+	if (const char *cr = static_cast<const char *>(std::memchr(nine, '\r', stop - nine)))
+	{
+		stop = cr;
+	}
+	totals.Add(std::string_view(start, stop - start));
+	from = stop == end ? end : stop + 1;
+	nine = from;
+  }
+
+  int64_t lost = static_cast<int64_t>(totals.txCount) - static_cast<int64_t>(totals.rxCount);
+  double pdr = totals.txCount > 0 ? static_cast<double>(totals.rxCount) / totals.txCount * 100 : 0;
+  double duration = totals.endTime > totals.startTime ? totals.endTime - totals.startTime : 1.0;
+  double throughput = static_cast<double>(totals.rxBytes * 8) / (duration * 1000);
+  const std::vector<double> &delays = totals.delays;
+
+  cout << "throughput=" << Repr(throughput) << "\n";
+  cout << "delay="
+       << (delays.empty() ? "0" : Repr(PairwiseSum(delays.data(), delays.size()) / delays.size()))
+       << "\n";
+  cout << "pdr=" << (totals.txCount > 0 ? Repr(pdr) : "0") << "\n";
+  cout << "lost=" << std::max<int64_t>(0, lost) << "\n";
+  cout << "tx_packets=" << totals.txCount << "\n";
+  cout << "rx_packets=" << totals.rxCount << "\n";
+  cout << "duration=" << Repr(duration) << "\n";
+  return 0;
+}
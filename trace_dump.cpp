@@ -0,0 +1,237 @@
+#include <iostream>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "packet-trace.h"
+
+using namespace std;
+
+// Per-flow totals of a binary packet trace.
+struct FlowTotals
+{
+  uint64_t enqueued = 0;
+  uint64_t received = 0;
+  uint64_t dropped = 0;
+  uint64_t rxBytes = 0;
+  double delaySum = 0; // ms
+  uint64_t delays = 0;
+  int64_t first = INT64_MAX;
+  int64_t last = INT64_MIN;
+};
+
+// uid -> time of its latest enqueue, open addressing with linear probing;
+// doubles once half full, so probing always reaches an empty slot.
+class UidTimes
+{
+public:
+  explicit UidTimes (size_t expected)
+  {
+	size_t size = 16;
+	while (size < 2 * expected)
+	{
+		size *= 2;
+	}
+	m_keys.assign(size, EMPTY);
+	m_times.resize(size);
+  }
+
+  void Set (uint64_t uid, int64_t time)
+  {
+	if (2 * (m_used + 1) > m_keys.size())
+	{
+		Grow();
+	}
+	size_t i = Slot(uid);
+	if (m_keys[i] == EMPTY)
+	{
+		m_keys[i] = uid;
+		m_used++;
+	}
+	m_times[i] = time;
+  }
+
+  bool Get (uint64_t uid, int64_t &time) const
+  {
+	size_t i = Slot(uid);
+	if (m_keys[i] != uid)
+	{
+		return false;
+	}
+	time = m_times[i];
+	return true;
+  }
+
+private:
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+
+  size_t Slot (uint64_t uid) const
+  {
+	const size_t mask = m_keys.size() - 1;
+	size_t i = (uid * 0x9e3779b97f4a7c15ULL) >> 20 & mask;
+	while (m_keys[i] != EMPTY && m_keys[i] != uid)
+	{
+		i = (i + 1) & mask;
+	}
+	return i;
+  }
+
+  void Grow ()
+  {
+	std::vector<uint64_t> keys(m_keys.size() * 2, EMPTY);
+	std::vector<int64_t> times(keys.size());
+	keys.swap(m_keys);
+	times.swap(m_times);
+	for (size_t j = 0; j < keys.size(); j++)
+	{
+		if (keys[j] != EMPTY)
+		{
+			size_t i = Slot(keys[j]);
+			m_keys[i] = keys[j];
+			m_times[i] = times[j];
+		}
+	}
+  }
+
+  std::vector<uint64_t> m_keys;
+  std::vector<int64_t> m_times;
+  size_t m_used = 0;
+};
+
+// "hash -> source:port > destination:port/protocol" from the .flows file
+// written next to the trace, if any.
+static std::map<uint32_t, std::string> LoadFlowNames (const std::string &path)
+{
+  std::map<uint32_t, std::string> names;
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  while (std::getline(in, line))
+  {
+	std::vector<std::string> f;
+	size_t start = 0;
+	for (size_t comma; (comma = line.find(',', start)) != std::string::npos; start = comma + 1)
+	{
+		f.push_back(line.substr(start, comma - start));
+	}
+	f.push_back(line.substr(start));
+	if (f.size() == 6)
+	{
+		names[std::stoul(f[0])] = f[1] + ":" + f[4] + " > " + f[2] + ":" + f[5] + "/" + f[3];
+	}
+  }
+  return names;
+}
+
+// Summarize or list a binary packet trace written by PacketTraceSink:
+//   trace_dump tracemetrics.ptr [--records] [--flow=HASH]
+// The summary gives, per 5-tuple hash, the enqueue/receive/drop counts,
+// received bytes and throughput, and the mean one-hop delay (receive time
+// minus the latest enqueue of the same packet uid), as analyse_performance.py
+// computes them from the ASCII trace.
+int main (int argc, char **argv)
+{
+  std::string path;
+  bool records = false;
+  bool filter = false;
+  uint32_t flow = 0;
+  for (int a = 1; a < argc; a++)
+  {
+	std::string arg = argv[a];
+	if (arg == "--records")
+	{
+		records = true;
+	}
+	else if (arg.compare(0, 7, "--flow=") == 0)
+	{
+		filter = true;
+		flow = std::stoul(arg.substr(7));
+	}
+	else if (path.empty())
+	{
+		path = arg;
+	}
+	else
+	{
+		cerr << "Unexpected argument " << arg << endl;
+		return 1;
+	}
+  }
+  if (path.empty())
+  {
+	cerr << "Usage: " << argv[0] << " trace.ptr [--records] [--flow=HASH]" << endl;
+	return 1;
+  }
+
+  PacketTraceReader trace;
+  std::string error;
+  if (!trace.Open(path, &error))
+  {
+	cerr << "Error in trace file: " << error << endl;
+	return 1;
+  }
+
+  if (records)
+  {
+	cout << "time,node,device,event,uid,size,protocol,flow\n";
+	cout.precision(10);
+	for (const PacketTraceRecord &r : trace)
+	{
+		if (filter && r.flow != flow)
+		{
+			continue;
+		}
+		cout << r.time * 1e-9 << "," << r.node << "," << r.device << "," << char(r.event) << ","
+		     << r.uid << "," << r.size << "," << uint32_t(r.protocol) << "," << r.flow << "\n";
+	}
+	return 0;
+  }
+
+  std::map<uint32_t, FlowTotals> flows;
+  UidTimes enqueued(trace.Size());
+  for (const PacketTraceRecord &r : trace)
+  {
+	if (filter && r.flow != flow)
+	{
+		continue;
+	}
+	FlowTotals &t = flows[r.flow];
+	t.first = std::min(t.first, r.time);
+	t.last = std::max(t.last, r.time);
+	if (r.event == PacketTraceRecord::ENQUEUE)
+	{
+		t.enqueued++;
+		enqueued.Set(r.uid, r.time);
+	}
+	else if (r.event == PacketTraceRecord::RECEIVE)
+	{
+		t.received++;
+		t.rxBytes += r.size;
+		int64_t sent;
+		if (enqueued.Get(r.uid, sent))
+		{
+			t.delaySum += (r.time - sent) * 1e-6;
+			t.delays++;
+		}
+	}
+	else if (r.event == PacketTraceRecord::DROP)
+	{
+		t.dropped++;
+	}
+  }
+
+  std::map<uint32_t, std::string> names = LoadFlowNames(path + ".flows");
+  cout << trace.Size() << " records\n";
+  cout << "flow\tenqueued\treceived\tdropped\trx_bytes\tthroughput(kbps)\tmean_delay(ms)\t5-tuple\n";
+  for (const auto &[hash, t] : flows)
+  {
+	double duration = t.last > t.first ? (t.last - t.first) * 1e-9 : 1.0;
+	cout << hash << "\t" << t.enqueued << "\t" << t.received << "\t" << t.dropped << "\t"
+	     << t.rxBytes << "\t" << t.rxBytes * 8.0 / duration / 1e3 << "\t"
+	     << (t.delays ? t.delaySum / t.delays : 0.0) << "\t"
+	     << (names.count(hash) ? names[hash] : "") << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,382 @@
+/*
+ * Traffic matrix: a flat list of UDP flows and a linear-time installer.
+ *
+ * Each FlowSpec names a source and a destination node (indices into the
+ * NodeContainer given to Install), its active window and its packet
+ * stream: constant bit rate, Poisson arrivals, or exponential on/off
+ * bursts. Install() puts one PacketSink on every distinct destination and
+ * one client per flow, with its own start and stop time, in a single pass;
+ * the helpers are built once and reused, so setting up thousands of flows
+ * costs a few microseconds each.
+ *
+ * Matrices can be read from CSV (see LoadTrafficMatrix), parsed in place
+ * with the topology loader's field parser.
+ */
+
+#ifndef TRAFFIC_MATRIX_H
+#define TRAFFIC_MATRIX_H
+
+#include "topology-loader.h"
+
+#include "ns3/abort.h"
+#include "ns3/address.h"
+#include "ns3/application-container.h"
+#include "ns3/application.h"
+#include "ns3/data-rate.h"
+#include "ns3/double.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/string.h"
+#include "ns3/udp-client-server-helper.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+struct FlowSpec
+{
+    enum Pattern : uint8_t
+    {
+        CBR,     //!< one packet every interval (UdpClient)
+        POISSON, //!< exponential gaps of mean interval
+        ONOFF,   //!< exponential on/off periods, one packet per interval while on
+    };
+
+    uint32_t source;       //!< sending node
+    uint32_t destination;  //!< receiving node
+    Time start;
+    Time stop;
+    Time interval;         //!< between two packets (mean for POISSON)
+    uint32_t packetSize;   //!< bytes
+    uint32_t maxPackets;   //!< 0 = no limit
+    Pattern pattern = CBR;
+    Time onTime;           //!< ONOFF: mean on period
+    Time offTime;          //!< ONOFF: mean off period
+};
+
+/**
+ * UDP source with exponentially distributed gaps between packets of a
+ * fixed size, i.e. Poisson arrivals.
+ */
+class PoissonUdpClient : public Application
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::PoissonUdpClient")
+                                .SetParent<Application>()
+                                .AddConstructor<PoissonUdpClient>();
+        return tid;
+    }
+
+    void Setup(Address remote, uint32_t packetSize, Time meanInterval, uint32_t maxPackets)
+    {
+        m_remote = remote;
+        m_packetSize = packetSize;
+        m_maxPackets = maxPackets;
+        m_gap = CreateObject<ExponentialRandomVariable>();
+        m_gap->SetAttribute("Mean", DoubleValue(meanInterval.GetSeconds()));
+    }
+
+  private:
+    void StartApplication() override
+    {
+        m_socket = Socket::CreateSocket(GetNode(), TypeId::LookupByName("ns3::UdpSocketFactory"));
+        m_socket->Bind();
+        m_socket->Connect(m_remote);
+        m_sent = 0;
+        m_event = Simulator::Schedule(Seconds(m_gap->GetValue()), &PoissonUdpClient::Send, this);
+    }
+
+    void StopApplication() override
+    {
+        Simulator::Cancel(m_event);
+        if (m_socket)
+        {
+            m_socket->Close();
+            m_socket = nullptr;
+        }
+    }
+
+    void Send()
+    {
+        m_socket->Send(Create<Packet>(m_packetSize));
+        if (m_maxPackets == 0 || ++m_sent < m_maxPackets)
+        {
+            m_event =
+                Simulator::Schedule(Seconds(m_gap->GetValue()), &PoissonUdpClient::Send, this);
+        }
+    }
+
+    Address m_remote;
+    uint32_t m_packetSize = 1024;
+    uint32_t m_maxPackets = 0;
+    uint32_t m_sent = 0;
+    Ptr<ExponentialRandomVariable> m_gap;
+    Ptr<Socket> m_socket;
+    EventId m_event;
+};
+
+class TrafficMatrix
+{
+  public:
+    void Reserve(size_t flows)
+    {
+        m_flows.reserve(flows);
+    }
+
+    void Add(const FlowSpec& flow)
+    {
+        m_flows.push_back(flow);
+    }
+
+    void Clear()
+    {
+        m_flows.clear();
+    }
+
+    size_t Size() const
+    {
+        return m_flows.size();
+    }
+
+    const std::vector<FlowSpec>& GetFlows() const
+    {
+        return m_flows;
+    }
+
+    /// Latest stop time of any flow (zero when empty).
+    Time GetEnd() const
+    {
+        Time end;
+        for (const FlowSpec& flow : m_flows)
+        {
+            end = std::max(end, flow.stop);
+        }
+        return end;
+    }
+
+    /**
+     * Install the sinks (listening on port from serverStart to serverStop)
+     * and the clients. A node is reached at the address of its first IPv4
+     * interface. Returns the clients, in flow order.
+     */
+    ApplicationContainer Install(const NodeContainer& nodes,
+                                 uint16_t port,
+                                 Time serverStart,
+                                 Time serverStop) const
+    {
+        std::vector<Address> remotes(nodes.GetN());
+        PacketSinkHelper sink("ns3::UdpSocketFactory",
+                              InetSocketAddress(Ipv4Address::GetAny(), port));
+        ApplicationContainer servers;
+        for (const FlowSpec& flow : m_flows)
+        {
+            NS_ABORT_MSG_IF(flow.source >= nodes.GetN() || flow.destination >= nodes.GetN(),
+                            "Flow " << flow.source << " -> " << flow.destination
+                                    << " names a node beyond " << nodes.GetN());
+            if (remotes[flow.destination].IsInvalid())
+            {
+                Ptr<Node> node = nodes.Get(flow.destination);
+                remotes[flow.destination] =
+                    InetSocketAddress(node->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal(), port);
+                servers.Add(sink.Install(node));
+            }
+        }
+        servers.Start(serverStart);
+        servers.Stop(serverStop);
+
+        // Remote and rate attributes change per flow; the helpers do not.
+        UdpClientHelper cbr;
+        OnOffHelper onOff("ns3::UdpSocketFactory", Address());
+        ApplicationContainer apps;
+        for (const FlowSpec& flow : m_flows)
+        {
+            const Address& remote = remotes[flow.destination];
+            Ptr<Node> node = nodes.Get(flow.source);
+            Ptr<Application> app;
+            if (flow.pattern == FlowSpec::POISSON)
+            {
+                Ptr<PoissonUdpClient> poisson = CreateObject<PoissonUdpClient>();
+                poisson->Setup(remote, flow.packetSize, flow.interval, flow.maxPackets);
+                node->AddApplication(poisson);
+                app = poisson;
+            }
+            else if (flow.pattern == FlowSpec::ONOFF)
+            {
+                onOff.SetAttribute("Remote", AddressValue(remote));
+                onOff.SetAttribute("PacketSize", UintegerValue(flow.packetSize));
+                const double bps = flow.packetSize * 8e9 / flow.interval.GetNanoSeconds();
+                onOff.SetAttribute("DataRate", DataRateValue(DataRate(uint64_t(bps))));
+                onOff.SetAttribute("MaxBytes",
+                                   UintegerValue(uint64_t(flow.maxPackets) * flow.packetSize));
+                onOff.SetAttribute("OnTime", StringValue(Exponential(flow.onTime)));
+                onOff.SetAttribute("OffTime", StringValue(Exponential(flow.offTime)));
+                app = onOff.Install(node).Get(0);
+            }
+            else
+            {
+                cbr.SetAttribute("Remote", AddressValue(remote));
+                cbr.SetAttribute("MaxPackets", UintegerValue(flow.maxPackets));
+                cbr.SetAttribute("Interval", TimeValue(flow.interval));
+                cbr.SetAttribute("PacketSize", UintegerValue(flow.packetSize));
+                app = cbr.Install(node).Get(0);
+            }
+            app->SetStartTime(flow.start);
+            app->SetStopTime(flow.stop);
+            apps.Add(app);
+        }
+        return apps;
+    }
+
+  private:
+    static std::string Exponential(Time mean)
+    {
+        return "ns3::ExponentialRandomVariable[Mean=" + std::to_string(mean.GetSeconds()) + "]";
+    }
+
+    std::vector<FlowSpec> m_flows;
+};
+
+/**
+ * Parse a traffic matrix from a buffer, one flow per row:
+ *
+ *   source,destination,pattern,start,stop,packet_size,interval[,max_packets[,on,off]]
+ *
+ * pattern is cbr, poisson or onoff; times are in seconds; max_packets
+ * defaults to 0 (no limit) and on/off to 1 s each. Blank lines and lines
+ * starting with '#' are skipped, as is a non-numeric header if it is the
+ * first other line; any other malformed row fails with its line number.
+ */
+inline bool
+ParseTrafficMatrixCsv(const char* data,
+                      size_t size,
+                      TrafficMatrix& matrix,
+                      std::string* error = nullptr)
+{
+    matrix.Clear();
+    const char* p = data;
+    const char* end = data + size;
+    matrix.Reserve(static_cast<size_t>(std::count(p, end, '\n')) + 1);
+
+    uint64_t line = 0;
+    bool seenRow = false; // a header may only precede the first row
+    while (p < end)
+    {
+        line++;
+        const char* next;
+        const char* eol = CsvLineEnd(p, end, next);
+        const char* f = p;
+        while (f < eol && (*f == ' ' || *f == '\t'))
+        {
+            f++;
+        }
+        if (f == eol || *f == '#')
+        {
+            p = next;
+            continue;
+        }
+        const char* first = f;
+        const bool firstRow = !seenRow;
+        seenRow = true;
+
+        FlowSpec flow;
+        double start;
+        double stop;
+        double interval;
+        double on = 1;
+        double off = 1;
+        flow.maxPackets = 0;
+        bool ok = CsvParseField(f, eol, flow.source) && CsvParseField(f, eol, flow.destination);
+        if (ok)
+        {
+            const char* comma = std::find(f, eol, ',');
+            std::string pattern(f, comma);
+            pattern.erase(0, pattern.find_first_not_of(" \t"));
+            pattern.erase(pattern.find_last_not_of(" \t") + 1);
+            f = comma < eol ? comma + 1 : eol;
+            if (pattern == "cbr")
+            {
+                flow.pattern = FlowSpec::CBR;
+            }
+            else if (pattern == "poisson")
+            {
+                flow.pattern = FlowSpec::POISSON;
+            }
+            else if (pattern == "onoff")
+            {
+                flow.pattern = FlowSpec::ONOFF;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        ok = ok && CsvParseField(f, eol, start) && CsvParseField(f, eol, stop) &&
+             CsvParseField(f, eol, flow.packetSize) && CsvParseField(f, eol, interval) &&
+             interval > 0 && stop >= start;
+        if (ok && f != eol)
+        {
+            ok = CsvParseField(f, eol, flow.maxPackets);
+        }
+        if (ok && f != eol)
+        {
+            ok = CsvParseField(f, eol, on) && CsvParseField(f, eol, off);
+        }
+        if (!ok || f != eol)
+        {
+            bool header = firstRow && !(*first >= '0' && *first <= '9');
+            if (!header)
+            {
+                if (error)
+                {
+                    *error = "malformed flow at line " + std::to_string(line);
+                }
+                return false;
+            }
+        }
+        else
+        {
+            flow.start = Seconds(start);
+            flow.stop = Seconds(stop);
+            flow.interval = Seconds(interval);
+            flow.onTime = Seconds(on);
+            flow.offTime = Seconds(off);
+            matrix.Add(flow);
+        }
+        p = next;
+    }
+    return true;
+}
+
+/// Read a traffic matrix CSV file (see ParseTrafficMatrixCsv).
+inline bool
+LoadTrafficMatrix(const std::string& path, TrafficMatrix& matrix, std::string* error = nullptr)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        if (error)
+        {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+    return ParseTrafficMatrixCsv(file.Data(), file.Size(), matrix, error);
+}
+
+} // namespace ns3
+
+#endif /* TRAFFIC_MATRIX_H */
@@ -0,0 +1,237 @@
+/*
+ * Reduced Wi-Fi pcap capture for high-rate runs.
+ *
+ * Frames seen by a WifiPhy's monitor sniffer (both directions, as
+ * YansWifiPhyHelper::EnablePcap records them) are cut to a snap length
+ * and sampled per flow: one frame in every sampleEvery of each flow is
+ * kept. A flow is the IPv4 5-tuple of data frames, or the frame type and
+ * receiver address of the others (ACKs, beacons, ...), so sparse flows
+ * are not crowded out by the dominant one. A-MPDU delimiters are
+ * stripped, giving a plain 802.11 (DLT 105) file Wireshark can dissect.
+ * Records go through a RingFileWriter, off the simulation thread.
+ */
+
+#ifndef WIFI_PCAP_CAPTURE_H
+#define WIFI_PCAP_CAPTURE_H
+
+#include "packet-trace.h"
+#include "ring-writer.h"
+
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class WifiPcapCapture
+{
+  public:
+    static constexpr uint32_t DLT_IEEE802_11 = 105;
+
+    ~WifiPcapCapture()
+    {
+        Close();
+    }
+
+    /**
+     * Create filename; frames are cut to snapLen bytes (0 = whole frame)
+     * and one in sampleEvery of each flow is written.
+     */
+    bool Open(const std::string& filename, uint32_t snapLen = 128, uint32_t sampleEvery = 1)
+    {
+        if (!m_writer.Open(filename))
+        {
+            return false;
+        }
+        m_snapLen = snapLen ? snapLen : 65535;
+        m_sampleEvery = std::max<uint32_t>(sampleEvery, 1);
+        m_seen.clear();
+        m_frames = 0;
+        m_written = 0;
+        m_buffer.resize(std::max<uint32_t>(m_snapLen, HEADERS) + 4);
+
+        struct
+        {
+            uint32_t magic = 0xa1b2c3d4; //!< microsecond timestamps, host order
+            uint16_t major = 2;
+            uint16_t minor = 4;
+            int32_t zone = 0;
+            uint32_t sigfigs = 0;
+            uint32_t snapLen;
+            uint32_t network = DLT_IEEE802_11;
+        } header;
+
+        header.snapLen = m_snapLen;
+        m_writer.Write(&header, sizeof(header));
+        return true;
+    }
+
+    /// Capture what the Wi-Fi PHY of device sends and receives.
+    void Watch(Ptr<NetDevice> device)
+    {
+        Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice>(device);
+        NS_ABORT_MSG_UNLESS(wifi, "WifiPcapCapture needs a WifiNetDevice");
+        wifi->GetPhy()->TraceConnectWithoutContext(
+            "MonitorSnifferTx",
+            MakeCallback(&WifiPcapCapture::SniffTx, this));
+        wifi->GetPhy()->TraceConnectWithoutContext(
+            "MonitorSnifferRx",
+            MakeCallback(&WifiPcapCapture::SniffRx, this));
+    }
+
+    void Close()
+    {
+        m_writer.Close();
+    }
+
+    /// Frames seen by the sniffers.
+    uint64_t GetFrames() const
+    {
+        return m_frames;
+    }
+
+    /// Frames written after sampling.
+    uint64_t GetWritten() const
+    {
+        return m_written;
+    }
+
+    uint64_t GetStalls() const
+    {
+        return m_writer.GetStalls();
+    }
+
+  private:
+    /// Bytes needed to find the 5-tuple: 802.11 + LLC/SNAP + IPv4 + ports.
+    static constexpr uint32_t HEADERS = 36 + 8 + 60 + 4;
+
+    void SniffTx(Ptr<const Packet> packet,
+                 uint16_t channelFreqMhz,
+                 WifiTxVector txVector,
+                 MpduInfo aMpdu,
+                 uint16_t staId)
+    {
+        Capture(packet, aMpdu);
+    }
+
+    void SniffRx(Ptr<const Packet> packet,
+                 uint16_t channelFreqMhz,
+                 WifiTxVector txVector,
+                 MpduInfo aMpdu,
+                 SignalNoiseDbm signalNoise,
+                 uint16_t staId)
+    {
+        Capture(packet, aMpdu);
+    }
+
+    void Capture(Ptr<const Packet> packet, const MpduInfo& aMpdu)
+    {
+        m_frames++;
+        uint8_t* data = m_buffer.data();
+        uint32_t length =
+            packet->CopyData(data, std::min<uint32_t>(packet->GetSize(), m_buffer.size()));
+        uint32_t frameLength = packet->GetSize();
+        if (aMpdu.type != NORMAL_MPDU && length >= 4)
+        {
+            // A-MPDU subframe: 4-byte delimiter (MPDU length in the low
+            // 14 bits), then the MPDU, then padding.
+            frameLength =
+                std::min<uint32_t>((data[0] | data[1] << 8) & 0x3fff, frameLength - 4);
+            data += 4;
+            length = std::min(length - 4, frameLength);
+        }
+        if (m_seen[FlowKey(data, length)]++ % m_sampleEvery != 0)
+        {
+            return;
+        }
+
+        const int64_t us = Simulator::Now().GetMicroSeconds();
+        const uint32_t caplen = std::min(length, m_snapLen);
+        const uint32_t record[4] = {static_cast<uint32_t>(us / 1000000),
+                                    static_cast<uint32_t>(us % 1000000),
+                                    caplen,
+                                    frameLength};
+        m_writer.Write(record, sizeof(record));
+        m_writer.Write(data, caplen);
+        m_written++;
+    }
+
+    static uint32_t Be32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+    }
+
+    static uint16_t Be16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+    /// 5-tuple hash of an IPv4 data frame, else hash of type and receiver.
+    static uint32_t FlowKey(const uint8_t* f, uint32_t n)
+    {
+        if (n < 10)
+        {
+            return 0;
+        }
+        const uint16_t fc = f[0] | f[1] << 8;
+        const uint8_t type = (fc >> 2) & 3;
+        const uint8_t subtype = (fc >> 4) & 15;
+        const bool qos = subtype & 8;
+        // Not data, null data or protected: key on type, subtype and addr1.
+        const uint32_t other =
+            PacketTraceFlowHash(Be32(f + 4), Be16(f + 8), 0, type << 4 | subtype, 0);
+        if (type != 2 || (subtype & 4) || (fc & 0x4000))
+        {
+            return other;
+        }
+        const uint32_t h = 24 + ((fc & 0x300) == 0x300 ? 6 : 0) + (qos ? 2 : 0) +
+                           (qos && (fc & 0x8000) ? 4 : 0);
+        static const uint8_t snap[8] = {0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00};
+        if (n < h + 8 + 20 || std::memcmp(f + h, snap, 8) != 0)
+        {
+            return other;
+        }
+        const uint8_t* ip = f + h + 8;
+        const uint32_t ihl = (ip[0] & 15) * 4;
+        const uint8_t protocol = ip[9];
+        const bool firstFragment = (Be16(ip + 6) & 0x1fff) == 0;
+        uint16_t sourcePort = 0;
+        uint16_t destinationPort = 0;
+        if ((protocol == 6 || protocol == 17) && firstFragment && ihl >= 20 &&
+            n >= h + 8 + ihl + 4)
+        {
+            sourcePort = Be16(ip + ihl);
+            destinationPort = Be16(ip + ihl + 2);
+        }
+        return PacketTraceFlowHash(Be32(ip + 12),
+                                   Be32(ip + 16),
+                                   protocol,
+                                   sourcePort,
+                                   destinationPort);
+    }
+
+    RingFileWriter m_writer;
+    uint32_t m_snapLen = 65535;
+    uint32_t m_sampleEvery = 1;
+    std::unordered_map<uint32_t, uint64_t> m_seen; //!< frames per flow key
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_frames = 0;
+    uint64_t m_written = 0;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_PCAP_CAPTURE_H */